@@ -0,0 +1,42 @@
+#version 120
+
+varying vec4 modelVertex;
+varying vec3 size;
+varying vec3 frame;
+varying vec4 bodyColor;
+varying vec4 frameColor;
+
+float boxDist(vec2 p, vec2 size, float radius) {
+	size -= vec2(radius+0.4);
+	vec2 d = abs(p) - (size);
+  return min(max(d.x, d.y), 0.0) + length(max(d, 0.0)) - radius;
+}
+
+
+float fillMask(float dist) {
+	return clamp(-dist, 0.0, 1.0);
+}
+
+
+float borderMask(float dist, float width) {
+	float alpha1 = clamp(dist + width, 0.0, 1.0);
+	float alpha2 = clamp(dist, 0.0, 1.0);
+	return alpha1 - alpha2;
+}
+
+
+void plight(vec4 base, out vec4 outcol) {
+  vec2 w = vec2(frame.x);
+  float d = boxDist(modelVertex.xy-0.5*(size.xy), 0.5*(size.xy-w), frame.y);
+  float m = fillMask(d);
+  outcol = mix(vec4(0,0,0,0), bodyColor, m);
+  m = borderMask(d, w.x);
+  outcol = mix(outcol, frameColor, m);
+}
+
+
+void main() {
+    vec4 col = vec4(1.0);
+    plight( vec4(1.0), col );
+    gl_FragColor = col;
+}
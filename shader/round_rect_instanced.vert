@@ -0,0 +1,26 @@
+#version 120
+
+attribute vec4 instanceRect;
+attribute vec4 instanceFrame;
+attribute vec4 instanceBodyColor;
+attribute vec4 instanceFrameColor;
+
+varying vec4 modelVertex;
+varying vec3 size;
+varying vec3 frame;
+varying vec4 bodyColor;
+varying vec4 frameColor;
+
+void main() {
+  size = vec3(instanceRect.zw, 1.0);
+  frame = vec3(instanceFrame.xy, 0.0);
+  bodyColor = instanceBodyColor;
+  frameColor = instanceFrameColor;
+  modelVertex = vec4(gl_Vertex.xy*size.xy, 0.0, 1.0);
+  // hidden bodies (instanceFrame.w == 0) collapse to a point
+  vec2 offset = modelVertex.xy*instanceFrame.z*instanceFrame.w;
+  vec4 vModelPos = vec4(instanceRect.xy+offset, 0.0, 1.0);
+  vec4 vViewPos = gl_ModelViewMatrix * vModelPos;
+  gl_Position = gl_ModelViewProjectionMatrix * vModelPos;
+  gl_ClipVertex = vViewPos;
+}
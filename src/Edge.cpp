@@ -18,7 +18,6 @@
 #include <osg/Texture2D>
 #include <osgDB/ReadFile>
 #include <mars/osg_material_manager/OsgMaterialManager.h>
-#include <mars/osg_material_manager/MaterialNode.h>
 
 using namespace configmaps;
 
@@ -40,34 +39,15 @@ namespace osg_graph_viz {
     offsetLimit = port_size_y / 2.0;
     view = v;
     hidden = false;
+    textVisible = true;
+    farZoom = false;
     materialManager = view->getOsgMaterialManager();
     selected = false;
     geode = new osg::Geode;
     geom = new osg::Geometry;
     geom->setDataVariance(osg::Object::DYNAMIC);
-    decoupleGeom = new osg::Geometry;
-    decoupleGeom->setDataVariance(osg::Object::DYNAMIC);
-
-    smoothGeom = new osg::Geometry;
-    smoothGeom->setDataVariance(osg::Object::DYNAMIC);
-
-    std::string loadPath = view->getResourcesPath();
-    if(loadPath[loadPath.size()-1] != '/') loadPath.append("/");
-    loadPath.append("shader/");
-    ConfigMap mMap = ConfigMap::fromYamlFile(loadPath + "smooth_edge.yml");
-    mMap["loadPath"] = loadPath;
-    materialManager->createMaterial("smooth_edge", mMap);
-    osg::ref_ptr<osg::Node> materialGroup = materialManager->getNewMaterialGroup("smooth_edge");
-    osg_material_manager::MaterialNode *materialNode = dynamic_cast<osg_material_manager::MaterialNode*>(materialGroup.get());
-
-    osg::ref_ptr<osg::StateSet> st = new osg::StateSet(*(materialNode->getMaterial()->getOrCreateStateSet()));
-    smoothGeom->setStateSet(st.get());
-    startUniform = new osg::Uniform("start", osg::Vec3f(0, 0, 0));
-    endUniform = new osg::Uniform("end", osg::Vec3f(1, 1, 0));
-    colorUniform = new osg::Uniform("color", osg::Vec4f(0, 0, 0, 1));
-    smoothGeom->getOrCreateStateSet()->addUniform(startUniform.get());
-    smoothGeom->getOrCreateStateSet()->addUniform(endUniform.get());
-    smoothGeom->getOrCreateStateSet()->addUniform(colorUniform.get());
+    geom->setUseDisplayList(false);
+    geom->setUseVertexBufferObjects(true);
 
     vertices = new osg::Vec3Array();
     double x, y, z;
@@ -78,131 +58,272 @@ namespace osg_graph_viz {
       vertices->push_back(osg::Vec3(x, y, z));
     }
 
-    decoupleVertices = new osg::Vec3Array();
-    if(!info.hasKey("decoupleVertices")) {
-      x = (*vertices.get())[0].x();
-      y = (*vertices.get())[0].y();
-      z = (*vertices.get())[0].z();
-      info["decoupleVertices"][0]["x"] = x;
-      info["decoupleVertices"][0]["y"] = y;
-      info["decoupleVertices"][0]["z"] = z;
-      info["decoupleVertices"][1]["x"] = x+25;
-      info["decoupleVertices"][1]["y"] = y;
-      info["decoupleVertices"][1]["z"] = z;
-      x = (*vertices.get()).back().x();
-      y = (*vertices.get()).back().y();
-      z = (*vertices.get()).back().z();
-      info["decoupleVertices"][2]["x"] = x-25;
-      info["decoupleVertices"][2]["y"] = y;
-      info["decoupleVertices"][2]["z"] = z;
-      info["decoupleVertices"][3]["x"] = x;
-      info["decoupleVertices"][3]["y"] = y;
-      info["decoupleVertices"][3]["z"] = z;
-    }
-    for(size_t i=0; i<info["decoupleVertices"].size(); ++i) {
-      x = info["decoupleVertices"][i]["x"];
-      y = info["decoupleVertices"][i]["y"];
-      z = info["decoupleVertices"][i]["z"];
-      decoupleVertices->push_back(osg::Vec3(x, y, z));
-    }
-
     geom->setVertexArray(vertices.get());
     startPos = (*vertices.get())[0].y();
     endPos = (*vertices.get())[vertices->size()-1].y();
     geom->addPrimitiveSet(new osg::DrawArrays(osg::PrimitiveSet::LINE_STRIP, 0,
                                               vertices->size()));
 
-    decoupleGeom->setVertexArray(decoupleVertices.get());
-    decoupleGeom->addPrimitiveSet(new osg::DrawArrays(osg::PrimitiveSet::LINES, 0,
-                                                      decoupleVertices->size()));
-
-    smoothVertices = new osg::Vec3Array();
-    for(int i=0; i<4; ++i) {
-      smoothVertices->push_back(osg::Vec3(0, 0, 0));
-    }
-    updateSmoothPos();
-    smoothGeom->setVertexArray(smoothVertices.get());
-    smoothGeom->addPrimitiveSet(new osg::DrawArrays(osg::PrimitiveSet::QUADS, 0,
-                                                      smoothVertices->size()));
-
-
     color = new osg::Vec4Array;
     color->push_back(osg::Vec4(0.0, 0.0, 0.0, 1.0));
     geom->setColorArray(color);
     geom->setColorBinding(osg::Geometry::BIND_OVERALL);
-    decoupleGeom->setColorArray(color);
-    decoupleGeom->setColorBinding(osg::Geometry::BIND_OVERALL);
-    smoothGeom->setColorArray(color);
-    smoothGeom->setColorBinding(osg::Geometry::BIND_OVERALL);
 
     osg::Vec3Array *normals = new osg::Vec3Array;
     normals->push_back(osg::Vec3(0.0f,0.0f,1.0f));
     geom->setNormalArray(normals);
     geom->setNormalBinding(osg::Geometry::BIND_OVERALL);
-    decoupleGeom->setNormalArray(normals);
-    decoupleGeom->setNormalBinding(osg::Geometry::BIND_OVERALL);
-    smoothGeom->setNormalArray(normals);
-    smoothGeom->setNormalBinding(osg::Geometry::BIND_OVERALL);
 
-    osg_text::Color c(0., 0., 0., 1.0);
-    if(info.hasKey("weight")) {
-      weight = new osg_text::Text(info["weight"].toString(), 8, c, 0, 0,
-                                  osg_text::ALIGN_LEFT, 0, 0, 0, 0,
-                                  osg_text::Color(), osg_text::Color(),
-                                  0, view->getResourcesPath()+"/fonts/Stilu-Light.ttf");
-      weight->setBackgroundColor(osg_text::Color(0.0, 0.0, 0.0, 0.0));
-      updateWeightPos();
-      if((double)info["weight"] > 1.0000001 ||
-         (double)info["weight"] < 0.9999999) {
-        this->addChild((osg::Node*)weight->getOSGNode());
-      }
-    }
-    geode->addDrawable(geom);
+    linew = new osg::LineWidth(1);
+    geode->getOrCreateStateSet()->setAttributeAndModes(linew.get(),
+                                                       osg::StateAttribute::ON);
+    toIdx = 0;
+    fromIdx = 0;
     decoupled = false;
+    updateWeight();
     this->addChild(geode);
 
-    toIdx = 0;
-    fromIdx = 0;
+    // the decouple and smooth parts are only built once they are shown
+    smooth = (bool)info["smooth"];
+    if(smooth) {
+      createSmooth();
+    }
+    if((bool)info["decouple"]) {
+      createDecouple();
+      this->addChild((osg::Node*)decoupleIn->getOSGNode());
+      this->addChild((osg::Node*)decoupleOut->getOSGNode());
+      geode->addDrawable(decoupleGeom);
+      decoupled = true;
+    }
+    else if(smooth) {
+      geode->addDrawable(smoothGeom);
+    }
+    else {
+      geode->addDrawable(geom);
+    }
+
+    startOffset = endOffset = 0.0;
+    pickOrder = 0;
+    inEdgeList = false;
+  }
+
+  void Edge::createDecouple() {
+    if(decoupleGeom.valid()) return;
+    decoupleVertices = new osg::Vec3Array();
+    osg::Vec3 v[4];
+    getDecoupleStubs(v);
+    for(size_t i=0; i<4; ++i) {
+      decoupleVertices->push_back(v[i]);
+    }
+
+    decoupleGeom = new osg::Geometry;
+    decoupleGeom->setDataVariance(osg::Object::DYNAMIC);
+    decoupleGeom->setUseDisplayList(false);
+    decoupleGeom->setUseVertexBufferObjects(true);
+    decoupleGeom->setVertexArray(decoupleVertices.get());
+    decoupleGeom->addPrimitiveSet(new osg::DrawArrays(osg::PrimitiveSet::LINES, 0,
+                                                      decoupleVertices->size()));
+    decoupleGeom->setColorArray(color);
+    decoupleGeom->setColorBinding(osg::Geometry::BIND_OVERALL);
+    decoupleGeom->setNormalArray(geom->getNormalArray());
+    decoupleGeom->setNormalBinding(osg::Geometry::BIND_OVERALL);
 
-    decoupleIn = new osg_text::Text("foo", 6, c, 0, 0,
+    osg_text::Color c(0., 0., 0., 1.0);
+    decoupleIn = new osg_text::Text("", 6, c, 0, 0,
                                     osg_text::ALIGN_RIGHT, 0, 0, 0, 0,
                                     osg_text::Color(), osg_text::Color(),
                                     0, view->getResourcesPath()+"/fonts/Stilu-Light.ttf");
-    decoupleIn->setBackgroundColor(osg_text::Color(0.98, 0.7, 0.98, 1.0));
     decoupleIn->setBorderColor(osg_text::Color(0.3, 0.3, 0.3, 1.0));
-    decoupleIn->setBorderWidth(3);
     decoupleIn->setPadding(6, 3, 6, 3);
-    decoupleOut = new osg_text::Text("foo", 6, c, 0, 0,
+    decoupleOut = new osg_text::Text("", 6, c, 0, 0,
                                      osg_text::ALIGN_LEFT, 0, 0, 0, 0,
                                      osg_text::Color(), osg_text::Color(),
                                      0, view->getResourcesPath()+"/fonts/Stilu-Light.ttf");
-    decoupleOut->setBackgroundColor(osg_text::Color(0.98, 0.7, 0.98, 1.0));
     decoupleOut->setBorderColor(osg_text::Color(0.3, 0.3, 0.3, 1.0));
-    decoupleOut->setBorderWidth(3);
     decoupleOut->setPadding(6, 3, 6, 3);
-    smooth = (bool)info["smooth"];
-    if((bool)info["decouple"]) {
-      this->addChild((osg::Node*)decoupleIn->getOSGNode());
-      this->addChild((osg::Node*)decoupleOut->getOSGNode());
-      geode->removeDrawable(geom);
-      geode->addDrawable(decoupleGeom);
-      decoupled = true;
-    }
-    else if(smooth) {
-      geode->removeDrawable(geom);
-      geode->removeDrawable(decoupleGeom);
-      geode->addDrawable(smoothGeom);
+    if(farZoom) {
+      ((osg::Node*)decoupleIn->getOSGNode())->setNodeMask(0);
+      ((osg::Node*)decoupleOut->getOSGNode())->setNodeMask(0);
     }
+    updateDecoupleLabels();
     updateDecouplePos();
-    linew = new osg::LineWidth(1);
-    geode->getOrCreateStateSet()->setAttributeAndModes(linew.get(),
-                                                       osg::StateAttribute::ON);
+  }
 
-    startOffset = endOffset = 0.0;
+  void Edge::getDecoupleStubs(osg::Vec3 *v) {
+    const osg::Vec3 &start = vertices->front();
+    const osg::Vec3 &end = vertices->back();
+    if(info.hasKey("decoupleVertices") && info["decoupleVertices"].size() == 4) {
+      // keep the stored stubs relative to the current end points
+      osg::Vec3 s[4];
+      for(size_t i=0; i<4; ++i) {
+        s[i] = osg::Vec3((double)info["decoupleVertices"][i]["x"],
+                         (double)info["decoupleVertices"][i]["y"],
+                         (double)info["decoupleVertices"][i]["z"]);
+      }
+      v[0] = start;
+      v[1] = start + s[1] - s[0];
+      v[2] = end + s[2] - s[3];
+      v[3] = end;
+    }
+    else {
+      v[0] = start;
+      v[1] = start + osg::Vec3(25, 0, 0);
+      v[2] = end - osg::Vec3(25, 0, 0);
+      v[3] = end;
+    }
+  }
+
+  void Edge::updateDecoupleLabels() {
+    if(!decoupleIn.valid()) return;
+    osg_text::Color inColor(0.98, 0.7, 0.98, 1.0);
+    osg_text::Color outColor(0.98, 0.7, 0.98, 1.0);
+    if(startNode.valid()) {
+      std::string name = startNode->getName();
+      if(!startNode->isInput()) {
+        name += " - ";
+        name += startNode->getOutPortName(fromIdx);
+      }
+      else {
+        inColor = osg_text::Color(0.98, 0.98, 0.7, 1.0);
+      }
+      decoupleIn->setText(name);
+    }
+    if(endNode.valid()) {
+      std::string name = endNode->getName();
+      if(!endNode->isOutput()) {
+        name += " - ";
+        name += endNode->getInPortName(toIdx);
+      }
+      else {
+        outColor = osg_text::Color(0.98, 0.98, 0.7, 1.0);
+      }
+      decoupleOut->setText(name);
+    }
+    if(selected) {
+      inColor = outColor = osg_text::Color(0.0, 0.7, 0.0, 1.0);
+    }
+    decoupleIn->setBackgroundColor(inColor);
+    decoupleOut->setBackgroundColor(outColor);
+    decoupleIn->setBorderWidth(linew->getWidth()*1.6);
+    decoupleOut->setBorderWidth(linew->getWidth()*1.6);
+  }
+
+  void Edge::createSmooth() {
+    if(smoothGeom.valid()) return;
+    smoothGeom = new osg::Geometry;
+    smoothGeom->setDataVariance(osg::Object::DYNAMIC);
+    smoothGeom->setUseDisplayList(false);
+    smoothGeom->setUseVertexBufferObjects(true);
+
+    // the material is shared by all edges, only the uniforms are per edge
+    smoothGeom->setStateSet(view->loadMaterial("smooth_edge"));
+    startUniform = new osg::Uniform("start", osg::Vec3f(0, 0, 0));
+    endUniform = new osg::Uniform("end", osg::Vec3f(1, 1, 0));
+    colorUniform = new osg::Uniform("color", (*color.get())[0]);
+    geode->getOrCreateStateSet()->addUniform(startUniform.get());
+    geode->getOrCreateStateSet()->addUniform(endUniform.get());
+    geode->getOrCreateStateSet()->addUniform(colorUniform.get());
+
+    smoothVertices = new osg::Vec3Array();
+    for(int i=0; i<4; ++i) {
+      smoothVertices->push_back(osg::Vec3(0, 0, 0));
+    }
+    updateSmoothPos();
+    smoothGeom->setVertexArray(smoothVertices.get());
+    smoothGeom->addPrimitiveSet(new osg::DrawArrays(osg::PrimitiveSet::QUADS, 0,
+                                                      smoothVertices->size()));
+    smoothGeom->setColorArray(color);
+    smoothGeom->setColorBinding(osg::Geometry::BIND_OVERALL);
+    smoothGeom->setNormalArray(geom->getNormalArray());
+    smoothGeom->setNormalBinding(osg::Geometry::BIND_OVERALL);
+  }
+
+  void Edge::createStraight() {
+    if(straightGeom.valid()) return;
+    straightGeode = new osg::Geode;
+    straightGeom = new osg::Geometry;
+    straightGeom->setDataVariance(osg::Object::DYNAMIC);
+    straightGeom->setUseDisplayList(false);
+    straightGeom->setUseVertexBufferObjects(true);
+    straightVertices = new osg::Vec3Array();
+    straightVertices->push_back(vertices->front());
+    straightVertices->push_back(vertices->back());
+    straightGeom->setVertexArray(straightVertices.get());
+    straightGeom->addPrimitiveSet(new osg::DrawArrays(osg::PrimitiveSet::LINES, 0, 2));
+    straightGeom->setColorArray(color);
+    straightGeom->setColorBinding(osg::Geometry::BIND_OVERALL);
+    straightGeom->setNormalArray(geom->getNormalArray());
+    straightGeom->setNormalBinding(osg::Geometry::BIND_OVERALL);
+    straightGeode->getOrCreateStateSet()->setAttributeAndModes(linew.get(),
+                                                               osg::StateAttribute::ON);
+    straightGeode->addDrawable(straightGeom);
+    this->addChild(straightGeode);
+  }
+
+  void Edge::setFarZoom(bool v) {
+    if(v == farZoom) return;
+    farZoom = v;
+    if(farZoom) {
+      createStraight();
+      (*straightVertices.get())[0] = vertices->front();
+      (*straightVertices.get())[1] = vertices->back();
+      straightVertices->dirty();
+      straightGeom->dirtyBound();
+    }
+    applyFarZoom();
+    updateBatch();
+  }
+
+  void Edge::applyFarZoom() {
+    unsigned int mask = farZoom ? 0 : ~0u;
+    geode->setNodeMask(mask);
+    if(decoupleIn.valid()) {
+      ((osg::Node*)decoupleIn->getOSGNode())->setNodeMask(mask);
+      ((osg::Node*)decoupleOut->getOSGNode())->setNodeMask(mask);
+    }
+    if(straightGeode.valid()) {
+      // decoupled edges are left out in the overview
+      bool show = farZoom && !hidden && !decoupled && !edgeBatch.valid();
+      straightGeode->setNodeMask(show ? ~0u : 0);
+    }
+  }
+
+  void Edge::updateWeight() {
+    // only weights different from one are shown
+    bool show = false;
+    if(info.hasKey("weight")) {
+      double w = info["weight"];
+      show = w > 1.0000001 || w < 0.9999999;
+    }
+    if(!show) {
+      if(weight.valid()) {
+        this->removeChild((osg::Node*)weight->getOSGNode());
+      }
+      return;
+    }
+    if(!weight.valid()) {
+      osg_text::Color c(0., 0., 0., 1.0);
+      weight = new osg_text::Text(info["weight"].toString(), 8, c, 0, 0,
+                                  osg_text::ALIGN_LEFT, 0, 0, 0, 0,
+                                  osg_text::Color(), osg_text::Color(),
+                                  0, view->getResourcesPath()+"/fonts/Stilu-Light.ttf");
+      weight->setBackgroundColor(osg_text::Color(0.0, 0.0, 0.0, 0.0));
+      ((osg::Node*)weight->getOSGNode())->setNodeMask(textVisible ? ~0u : 0u);
+    }
+    else {
+      weight->setText(info["weight"].toString());
+    }
+    updateWeightPos();
+    if(!this->containsNode((osg::Node*)weight->getOSGNode())) {
+      this->addChild((osg::Node*)weight->getOSGNode());
+    }
   }
 
 
   Edge::~Edge(void) {
+    if(edgeBatch.valid()) {
+      edgeBatch->remove(this);
+    }
   }
 
 
@@ -211,7 +332,7 @@ namespace osg_graph_viz {
     osg::Vec3Array *v;
     int select = 0;
     if(hidden) return 0;
-    if(smooth && !(bool)info["decouple"]) {
+    if(smooth && !decoupled) {
       osg::Vec3 start = (*smoothVertices.get())[0];
       osg::Vec3 end = (*smoothVertices.get())[2];
       double startx = start.x() < end.x()? start.x() : end.x();
@@ -252,14 +373,14 @@ namespace osg_graph_viz {
       }
     }
     else {
-      if((bool)info["decouple"]) {
+      if(decoupled) {
         v = decoupleVertices.get();
       }
       else {
         v = vertices.get();
       }
 
-      if((bool)info["decouple"]) {
+      if(decoupled) {
         double left, right, top, bottom;
         decoupleIn->getRectangle(&left, &right, &top, &bottom);
         if(x>left && x < right && y > bottom && y < top) {
@@ -283,7 +404,7 @@ namespace osg_graph_viz {
         l += sqrt(pow((*v)[i+1].x() - x, 2.) + pow((*v)[i+1].y() - y, 2.));
         l2 = sqrt(pow((*v)[i].x() - (*v)[i+1].x(), 2.) +
                   pow((*v)[i].y() - (*v)[i+1].y(), 2.));
-        if(!(bool)info["decouple"] || i != 1) {
+        if(!decoupled || i != 1) {
           if(fabs(l2-l) / l2 < 0.5 / (2*l2)) {
             select = 1;
             break;
@@ -311,9 +432,6 @@ namespace osg_graph_viz {
     v.y() = (int)v.y();
     v.z() = (int)v.z();
     (*vertices.get())[i].set(v);
-    info["vertices"][i]["x"] = v.x();
-    info["vertices"][i]["y"] = v.y();
-    info["vertices"][i]["z"] = v.z();
     updateWeightPos();
     updateDecouplePos();
     updateSmoothPos();
@@ -321,6 +439,29 @@ namespace osg_graph_viz {
   }
 
   void Edge::updateStartPos(osg::Vec3 v) {
+    moveStart(v);
+    updateParts();
+  }
+
+  void Edge::updateEndPos(osg::Vec3 v) {
+    moveEnd(v);
+    updateParts();
+  }
+
+  void Edge::updateEndPoints(const EdgeEndPoints &p) {
+    if(p.hasStart) moveStart(p.start);
+    if(p.hasEnd) moveEnd(p.end);
+    updateParts();
+  }
+
+  void Edge::updateParts() {
+    updateWeightPos();
+    updateDecouplePos();
+    updateSmoothPos();
+    dirty();
+  }
+
+  void Edge::moveStart(osg::Vec3 v) {
     size_t size = vertices->size();
     v.x() = (int)v.x();
     v.y() = (int)v.y();
@@ -329,30 +470,17 @@ namespace osg_graph_viz {
     v.y() += startOffset;
     osg::Vec3 offset = v - (*vertices.get())[0];
     (*vertices.get())[0].set(v);
-    info["vertices"][0]["x"] = v.x();
-    info["vertices"][0]["y"] = v.y();
-    info["vertices"][0]["z"] = v.z();
-
-    (*decoupleVertices.get())[0].set(v);
-    info["decoupleVertices"][0]["x"] = v.x();
-    info["decoupleVertices"][0]["y"] = v.y();
-    info["decoupleVertices"][0]["z"] = v.z();
-    (*decoupleVertices.get())[1] += offset;
-    info["decoupleVertices"][1]["x"] = (*decoupleVertices.get())[1].x();
-    info["decoupleVertices"][1]["y"] = (*decoupleVertices.get())[1].y();
-    info["decoupleVertices"][1]["z"] = (*decoupleVertices.get())[1].z();
+
+    if(decoupleVertices.valid()) {
+      (*decoupleVertices.get())[0].set(v);
+      (*decoupleVertices.get())[1] += offset;
+    }
 
     if(size > 3) {
       //(*vertices.get())[size-2].y() = v.y();
       //info["vertices"][size-2]["y"] = v.y();
       (*vertices.get())[1] += offset;
-      info["vertices"][1]["x"] = (*vertices.get())[1].x();
-      info["vertices"][1]["y"] = (*vertices.get())[1].y();
-      info["vertices"][1]["z"] = (*vertices.get())[1].z();
       (*vertices.get())[2] += offset;
-      info["vertices"][2]["x"] = (*vertices.get())[2].x();
-      info["vertices"][2]["y"] = (*vertices.get())[2].y();
-      info["vertices"][2]["z"] = (*vertices.get())[2].z();
       checkEndPositions();
     }
 
@@ -361,13 +489,9 @@ namespace osg_graph_viz {
     //   info["vertices"][1]["y"] = v.y();
     //   checkEndPositions();
     // }
-    updateWeightPos();
-    updateDecouplePos();
-    updateSmoothPos();
-    dirty();
   }
 
-  void Edge::updateEndPos(osg::Vec3 v) {
+  void Edge::moveEnd(osg::Vec3 v) {
     size_t size = vertices->size();
     v.x() = (int)v.x();
     v.y() = (int)v.y();
@@ -376,37 +500,19 @@ namespace osg_graph_viz {
     v.y() += endOffset;
     osg::Vec3 offset = v - vertices->back();
     vertices->back().set(v);
-    info["vertices"][size-1]["x"] = v.x();
-    info["vertices"][size-1]["y"] = v.y();
-    info["vertices"][size-1]["z"] = v.z();
-
-    (*decoupleVertices.get())[3].set(v);
-    info["decoupleVertices"][3]["x"] = v.x();
-    info["decoupleVertices"][3]["y"] = v.y();
-    info["decoupleVertices"][3]["z"] = v.z();
-    (*decoupleVertices.get())[2] += offset;
-    info["decoupleVertices"][2]["x"] = (*decoupleVertices.get())[2].x();
-    info["decoupleVertices"][2]["y"] = (*decoupleVertices.get())[2].y();
-    info["decoupleVertices"][2]["z"] = (*decoupleVertices.get())[2].z();
+
+    if(decoupleVertices.valid()) {
+      (*decoupleVertices.get())[3].set(v);
+      (*decoupleVertices.get())[2] += offset;
+    }
 
     if(size > 3) {
       //(*vertices.get())[size-2].y() = v.y();
       //info["vertices"][size-2]["y"] = v.y();
       (*vertices.get())[size-2] += offset;
-      info["vertices"][size-2]["x"] = (*vertices.get())[size-2].x();
-      info["vertices"][size-2]["y"] = (*vertices.get())[size-2].y();
-      info["vertices"][size-2]["z"] = (*vertices.get())[size-2].z();
       (*vertices.get())[size-3] += offset;
-      info["vertices"][size-3]["x"] = (*vertices.get())[size-3].x();
-      info["vertices"][size-3]["y"] = (*vertices.get())[size-3].y();
-      info["vertices"][size-3]["z"] = (*vertices.get())[size-3].z();
       checkEndPositions();
     }
-
-    updateWeightPos();
-    updateDecouplePos();
-    updateSmoothPos();
-    dirty();
   }
 
   void Edge::updateWeightPos() {
@@ -414,7 +520,7 @@ namespace osg_graph_viz {
 
     double x=0, y=0;
     // Todo: need decouple handling
-    if((bool)info["decouple"]) {
+    if(decoupled) {
 
     }
     else {
@@ -435,6 +541,7 @@ namespace osg_graph_viz {
   }
 
   void Edge::updateDecouplePos() {
+    if(!decoupleVertices.valid()) return;
     double x=0, y=0;
     x = (*decoupleVertices.get())[2].x()+5;
     y = (*decoupleVertices.get())[2].y()+3;
@@ -467,14 +574,14 @@ namespace osg_graph_viz {
     if(size > 3) {
       if(((*vertices.get())[1].x() -
           (*vertices.get())[0].x()) < 5.) {
-        info["vertices"][1]["x"] = (*vertices.get())[1].x() = (*vertices.get())[0].x()+5.;
-        info["vertices"][2]["x"] = (*vertices.get())[2].x() = (*vertices.get())[0].x()+5.;
+        (*vertices.get())[1].x() = (*vertices.get())[0].x()+5.;
+        (*vertices.get())[2].x() = (*vertices.get())[0].x()+5.;
 
       }
       if(((*vertices.get())[size-1].x() -
           (*vertices.get())[size-2].x()) < 5.) {
-        info["vertices"][size-2]["x"] = (*vertices.get())[size-2].x() = (*vertices.get())[size-1].x()-5.;
-        info["vertices"][size-3]["x"] = (*vertices.get())[size-3].x() = (*vertices.get())[size-1].x()-5.;
+        (*vertices.get())[size-2].x() = (*vertices.get())[size-1].x()-5.;
+        (*vertices.get())[size-3].x() = (*vertices.get())[size-1].x()-5.;
       }
     }
   }
@@ -483,45 +590,41 @@ namespace osg_graph_viz {
     int size = vertices->size();
     x = (int)x;
     y = (int)y;
-    if((bool)info["decouple"]) {
+    if(decoupled) {
       x += dOffsetX;
       y += dOffsetY;
       if(node == 0) {
         limit_y_offset(startPos, &y, &startOffset);
         (*decoupleVertices.get())[node].y() = y;
-        info["decoupleVertices"][node]["y"] = y;
       }
       else if(node == 3) {
         limit_y_offset(endPos, &y, &endOffset);
         (*decoupleVertices.get())[node].y() = y;
-        info["decoupleVertices"][node]["y"] = y;
       }
       else {
         (*decoupleVertices.get())[node].x() = x;
-        info["decoupleVertices"][node]["x"] = x;
         (*decoupleVertices.get())[node].y() = y;
-        info["decoupleVertices"][node]["y"] = y;
       }
     }
     else if(size > 3) {
       if(node == 0) {
         limit_y_offset(startPos, &y, &startOffset);
-        info["vertices"][0]["y"] = (*vertices.get())[0].y() = y;
-        info["vertices"][1]["y"] = (*vertices.get())[1].y() = y;
+        (*vertices.get())[0].y() = y;
+        (*vertices.get())[1].y() = y;
       }
       else if(node == size-2) {
         limit_y_offset(endPos, &y, &endOffset);
-        info["vertices"][size-1]["y"] = (*vertices.get())[size-1].y() = y;
-        info["vertices"][size-2]["y"] = (*vertices.get())[size-2].y() = y;
+        (*vertices.get())[size-1].y() = y;
+        (*vertices.get())[size-2].y() = y;
       }
       else if(node > 0 && node < size-2) {
         if(horizontal) {
-          info["vertices"][node]["y"] = (*vertices.get())[node].y() = y;
-          info["vertices"][node+1]["y"] = (*vertices.get())[node+1].y() = y;
+          (*vertices.get())[node].y() = y;
+          (*vertices.get())[node+1].y() = y;
         }
         else {
-          info["vertices"][node]["x"] = (*vertices.get())[node].x() = x;
-          info["vertices"][node+1]["x"] = (*vertices.get())[node+1].x() = x;
+          (*vertices.get())[node].x() = x;
+          (*vertices.get())[node+1].x() = x;
         }
       }
       checkEndPositions();
@@ -533,7 +636,7 @@ namespace osg_graph_viz {
       else if(node == size-1) {
         limit_y_offset(endPos, &y, &endOffset);
       }
-      info["vertices"][node]["y"] = (*vertices.get())[node].y() = y;
+      (*vertices.get())[node].y() = y;
     }
     updateDecouplePos();
     updateWeightPos();
@@ -552,8 +655,8 @@ namespace osg_graph_viz {
     size_t size = vertices->size();
     x = (int)x;
     if(size > 3) {
-      info["vertices"][1]["x"] = (*vertices.get())[1].x() = (int)x;
-      info["vertices"][2]["x"] = (*vertices.get())[2].x() = (int)x;
+      (*vertices.get())[1].x() = (int)x;
+      (*vertices.get())[2].x() = (int)x;
     }
     checkEndPositions();
     updateSmoothPos();
@@ -562,16 +665,45 @@ namespace osg_graph_viz {
 
   void Edge::setLineWidth(double w) {
     linew->setWidth(w);
-    decoupleIn->setBorderWidth(w*1.6);
-    decoupleOut->setBorderWidth(w*1.6);
+    if(decoupleIn.valid()) {
+      decoupleIn->setBorderWidth(w*1.6);
+      decoupleOut->setBorderWidth(w*1.6);
+    }
   }
 
   void Edge::setColor(osg::Vec4 v) {
-    colorUniform->set(v);
+    if(colorUniform.valid()) {
+      colorUniform->set(v);
+    }
     (*color.get())[0] = v;
     dirty();
   }
 
+  const ConfigMap& Edge::getMap() {
+    // the vertex arrays are the source of truth, the map is only
+    // written when it is requested
+    for(size_t i=0; i<vertices->size(); ++i) {
+      info["vertices"][i]["x"] = (*vertices.get())[i].x();
+      info["vertices"][i]["y"] = (*vertices.get())[i].y();
+      info["vertices"][i]["z"] = (*vertices.get())[i].z();
+    }
+    // the stubs are written for every edge, as they were before they
+    // were created on demand
+    osg::Vec3 v[4];
+    if(decoupleVertices.valid()) {
+      for(size_t i=0; i<4; ++i) v[i] = (*decoupleVertices.get())[i];
+    }
+    else {
+      getDecoupleStubs(v);
+    }
+    for(size_t i=0; i<4; ++i) {
+      info["decoupleVertices"][i]["x"] = v[i].x();
+      info["decoupleVertices"][i]["y"] = v[i].y();
+      info["decoupleVertices"][i]["z"] = v[i].z();
+    }
+    return info;
+  }
+
   void Edge::updateMap(const ConfigMap &map) {
     info = map;
     for(size_t i=0; i<info["vertices"].size(); ++i) {
@@ -579,31 +711,26 @@ namespace osg_graph_viz {
       (*vertices.get())[i].y() = (double)info["vertices"][i]["y"];
       (*vertices.get())[i].z() = (double)info["vertices"][i]["z"];
     }
-    for(size_t i=0; i<info["decoupleVertices"].size(); ++i) {
-      (*decoupleVertices.get())[i].x() = (double)info["decoupleVertices"][i]["x"];
-      (*decoupleVertices.get())[i].y() = (double)info["decoupleVertices"][i]["y"];
-      (*decoupleVertices.get())[i].z() = (double)info["decoupleVertices"][i]["z"];
-    }
-    if(weight.valid()) {
-      weight->setText(info["weight"].toString());
-      updateWeightPos();
-      if((double)info["weight"] > 1.0000001 ||
-         (double)info["weight"] < 0.9999999) {
-        this->addChild((osg::Node*)weight->getOSGNode());
-      }
-      else {
-        this->removeChild((osg::Node*)weight->getOSGNode());
+    if(decoupleVertices.valid()) {
+      for(size_t i=0; i<info["decoupleVertices"].size(); ++i) {
+        (*decoupleVertices.get())[i].x() = (double)info["decoupleVertices"][i]["x"];
+        (*decoupleVertices.get())[i].y() = (double)info["decoupleVertices"][i]["y"];
+        (*decoupleVertices.get())[i].z() = (double)info["decoupleVertices"][i]["z"];
       }
+      this->removeChild((osg::Node*)decoupleIn->getOSGNode());
+      this->removeChild((osg::Node*)decoupleOut->getOSGNode());
+      geode->removeDrawable(decoupleGeom);
     }
-    this->removeChild((osg::Node*)decoupleIn->getOSGNode());
-    this->removeChild((osg::Node*)decoupleOut->getOSGNode());
-    geode->removeDrawable(decoupleGeom);
+    updateWeight();
     geode->removeDrawable(geom);
-    geode->removeDrawable(smoothGeom);
+    if(smoothGeom.valid()) {
+      geode->removeDrawable(smoothGeom);
+    }
     decoupled = false;
     smooth = false;
 
     if((bool)info["decouple"]) {
+      createDecouple();
       this->addChild((osg::Node*)decoupleIn->getOSGNode());
       this->addChild((osg::Node*)decoupleOut->getOSGNode());
       geode->addDrawable(decoupleGeom);
@@ -611,38 +738,67 @@ namespace osg_graph_viz {
     }
     else if((bool)info["smooth"]) {
       smooth = true;
+      createSmooth();
       geode->addDrawable(smoothGeom);
     }
     else {
       geode->addDrawable(geom);
     }
+    updateDecouplePos();
     updateSmoothPos();
+    applyFarZoom();
     dirty();
+    view->updateEdgeBundle(this);
   }
 
   void Edge::dirty(void) {
-    geom->dirtyDisplayList();
+    vertices->dirty();
     geom->dirtyBound();
-    decoupleGeom->dirtyDisplayList();
-    decoupleGeom->dirtyBound();
-    smoothGeom->dirtyDisplayList();
-    smoothGeom->dirtyBound();
-    smoothVertices->dirty();
+    if(decoupleGeom.valid()) {
+      decoupleVertices->dirty();
+      decoupleGeom->dirtyBound();
+    }
+    if(smoothGeom.valid()) {
+      smoothVertices->dirty();
+      smoothGeom->dirtyBound();
+    }
+    if(farZoom) {
+      (*straightVertices.get())[0] = vertices->front();
+      (*straightVertices.get())[1] = vertices->back();
+      straightVertices->dirty();
+      straightGeom->dirtyBound();
+    }
+    color->dirty();
+    updateBatch();
+    view->updateEdgeBounds(this);
   }
 
-  void Edge::setStartNode(osg_graph_viz::Node* node) {
-    std::string name;
-    startNode = node;
-    name = startNode->getName();
-    if(!startNode->isInput()) {
-      name += " - ";
-      name += startNode->getOutPortName(fromIdx);
-      decoupleIn->setBackgroundColor(osg_text::Color(0.98, 0.7, 0.98, 1.0));
+  void Edge::setEdgeBatch(EdgeBatch *batch) {
+    if(edgeBatch.valid()) {
+      edgeBatch->remove(this);
     }
-    else {
-      decoupleIn->setBackgroundColor(osg_text::Color(0.98, 0.98, 0.7, 1.0));
+    edgeBatch = batch;
+    geom->setNodeMask(edgeBatch.valid() ? 0 : ~0);
+    applyFarZoom();
+    updateBatch();
+  }
+
+  void Edge::updateBatch() {
+    if(!edgeBatch.valid()) return;
+    if(farZoom) {
+      edgeBatch->update(this, straightVertices.get(), (*color.get())[0],
+                        !hidden && !decoupled);
+      return;
     }
-    decoupleIn->setText(name);
+    // the geometry is only part of the geode while the polyline is shown
+    edgeBatch->update(this, vertices.get(), (*color.get())[0],
+                      geode->containsDrawable(geom.get()));
+  }
+
+  void Edge::setStartNode(osg_graph_viz::Node* node) {
+    startNode = node;
+    updateDecoupleLabels();
+    view->updateEdgeBundle(this);
   }
 
   osg_graph_viz::Node* Edge::getStartNode() {
@@ -650,18 +806,9 @@ namespace osg_graph_viz {
   }
 
   void Edge::setEndNode(osg_graph_viz::Node* node) {
-    std::string name;
     endNode = node;
-    name = endNode->getName();
-    if(!endNode->isOutput()) {
-      name += " - ";
-      name += endNode->getInPortName(toIdx);
-      decoupleOut->setBackgroundColor(osg_text::Color(0.98, 0.7, 0.98, 1.0));
-    }
-    else {
-      decoupleOut->setBackgroundColor(osg_text::Color(0.98, 0.98, 0.7, 1.0));
-    }
-    decoupleOut->setText(name);
+    updateDecoupleLabels();
+    view->updateEdgeBundle(this);
   }
 
   osg_graph_viz::Node* Edge::getEndNode() {
@@ -689,13 +836,13 @@ namespace osg_graph_viz {
     y = posOffsetY + y - (*vertices.get())[0].y();
 
     if(size == 2) {
-      info["vertices"][0]["x"] = (*vertices.get())[0].x() += (int)x;
-      info["vertices"][0]["y"] = (*vertices.get())[0].y() += (int)y;
+      (*vertices.get())[0].x() += (int)x;
+      (*vertices.get())[0].y() += (int)y;
     }
     else {
       for(size_t i=0; i<size-2; ++i) {
-        info["vertices"][i]["x"] = (*vertices.get())[i].x() += (int)x;
-        info["vertices"][i]["y"] = (*vertices.get())[i].y() += (int)y;
+        (*vertices.get())[i].x() += (int)x;
+        (*vertices.get())[i].y() += (int)y;
       }
     }
     updateDecouplePos();
@@ -705,72 +852,56 @@ namespace osg_graph_viz {
 
   void Edge::setSelected(bool v) {
     selected = v;
+    updateDecoupleLabels();
     if(v) {
-      decoupleIn->setBackgroundColor(osg_text::Color(0.0, 0.7, 0.0, 1.0));
-      decoupleOut->setBackgroundColor(osg_text::Color(0.0, 0.7, 0.0, 1.0));
       setColor(osg::Vec4(0.0, 0.7, 0.0, 1.0));
     }
     else {
-      if(startNode.valid() && startNode->isInput()) {
-        decoupleIn->setBackgroundColor(osg_text::Color(0.98, 0.98, 0.7, 1.0));
-      }
-      else {
-        decoupleIn->setBackgroundColor(osg_text::Color(0.98, 0.7, 0.98, 1.0));
-      }
-      if(endNode.valid() && endNode->isOutput()) {
-        decoupleOut->setBackgroundColor(osg_text::Color(0.98, 0.98, 0.7, 1.0));
-      }
-      else {
-        decoupleOut->setBackgroundColor(osg_text::Color(0.98, 0.7, 0.98, 1.0));
-      }
       setColor(osg::Vec4(0.0, 0.0, 0.0, 1.0));
     }
   }
 
   void Edge::decouple(double threshhold) {
-    if(!(bool)info["decouple"] && !decoupled) {
+    if(!decoupled) {
       osg::Vec3 v = getEndPosition()-getStartPosition();
       if(v.length() > threshhold) decoupleEdge();
     }
   }
 
   void Edge::decoupleEdge() {
-    if(!(bool)info["decouple"] && !decoupled) {
+    if(!decoupled) {
       info["decouple"] = true;
+      createDecouple();
       this->addChild((osg::Node*)decoupleIn->getOSGNode());
       this->addChild((osg::Node*)decoupleOut->getOSGNode());
-      geode->removeDrawable(smoothGeom);
+      if(smoothGeom.valid()) {
+        geode->removeDrawable(smoothGeom);
+      }
       geode->removeDrawable(geom);
       geode->addDrawable(decoupleGeom);
       decoupled = true;
+      applyFarZoom();
       double v = 25;
 
-      info["decoupleVertices"][0]["x"] = (*vertices.get())[0].x();
       (*decoupleVertices.get())[0].x() = (*vertices.get())[0].x();
-      info["decoupleVertices"][0]["y"] = (*vertices.get())[0].y();
       (*decoupleVertices.get())[0].y() = (*vertices.get())[0].y();
-      info["decoupleVertices"][1]["x"] = (*vertices.get())[0].x()+v;
       (*decoupleVertices.get())[1].x() = (*vertices.get())[0].x()+v;
-      info["decoupleVertices"][1]["y"] = (*vertices.get())[0].y();
       (*decoupleVertices.get())[1].y() = (*vertices.get())[0].y();
 
-      info["decoupleVertices"][2]["x"] = (*vertices.get()).back().x()-v;
       (*decoupleVertices.get())[2].x() = (*vertices.get()).back().x()-v;
-      info["decoupleVertices"][2]["y"] = (*vertices.get()).back().y();
       (*decoupleVertices.get())[2].y() = (*vertices.get()).back().y();
-      info["decoupleVertices"][3]["x"] = (*vertices.get()).back().x();
       (*decoupleVertices.get())[3].x() = (*vertices.get()).back().x();
-      info["decoupleVertices"][3]["y"] = (*vertices.get()).back().y();
       (*decoupleVertices.get())[3].y() = (*vertices.get()).back().y();
 
       updateDecouplePos();
       updateWeightPos();
       dirty();
+      view->updateEdgeBundle(this);
     }
   }
 
   bool Edge::isDecoupled(){
-    return (bool)info["decouple"];
+    return decoupled;
   }
 
   osg::Vec3 Edge::getEndPosition() {
@@ -782,41 +913,29 @@ namespace osg_graph_viz {
   }
 
   void Edge::derenderText(const bool readable){
+    textVisible = readable;
     if(!weight.valid()) return;
-    if(readable){//adds text to the Graph, here the texts are the weight of the Edge
-      if((double)info["weight"] > 1.0000001 ||
-         (double)info["weight"] < 0.9999999) {
-        this->removeChild((osg::Node*)weight->getOSGNode());
-        this->addChild((osg::Node*)weight->getOSGNode());
-      }
-    }
-
-    else{//removes text from the Graph
-      this->removeChild((osg::Node*)weight->getOSGNode());
-    }
+    ((osg::Node*)weight->getOSGNode())->setNodeMask(readable ? ~0u : 0u);
   }
 
   void Edge::reposition() {
-    info["vertices"][vertices->size()-1]["y"] = (*vertices.get())[vertices->size()-1].y() -= endOffset;
+    (*vertices.get())[vertices->size()-1].y() -= endOffset;
     if(vertices->size() > 3) {
-      info["vertices"][vertices->size()-2]["y"] = (*vertices.get())[vertices->size()-2].y() -= endOffset;
-      info["vertices"][vertices->size()-3]["y"] = (*vertices.get())[vertices->size()-3].y() -= endOffset;
+      (*vertices.get())[vertices->size()-2].y() -= endOffset;
+      (*vertices.get())[vertices->size()-3].y() -= endOffset;
     }
-    info["vertices"][0]["y"] = (*vertices.get())[0].y() -= startOffset;
+    (*vertices.get())[0].y() -= startOffset;
     if(vertices->size() > 3) {
-      info["vertices"][1]["y"] = (*vertices.get())[1].y() -= startOffset;
-      info["vertices"][2]["y"] = (*vertices.get())[2].y() -= startOffset;
-    }
-    (*decoupleVertices.get())[0] = (*vertices.get()).front();
-    (*decoupleVertices.get())[1] = (*vertices.get()).front();
-    (*decoupleVertices.get())[1].x() += 25;
-    (*decoupleVertices.get())[3] = (*vertices.get()).back();
-    (*decoupleVertices.get())[2] = (*vertices.get()).back();
-    (*decoupleVertices.get())[2].x() -= 25;
-    for(size_t i=0; i<4; ++i) {
-      info["decoupleVertices"][i]["x"] = (*decoupleVertices.get())[i].x();
-      info["decoupleVertices"][i]["y"] = (*decoupleVertices.get())[i].y();
-      info["decoupleVertices"][i]["z"] = (*decoupleVertices.get())[i].z();
+      (*vertices.get())[1].y() -= startOffset;
+      (*vertices.get())[2].y() -= startOffset;
+    }
+    if(decoupleVertices.valid()) {
+      (*decoupleVertices.get())[0] = (*vertices.get()).front();
+      (*decoupleVertices.get())[1] = (*vertices.get()).front();
+      (*decoupleVertices.get())[1].x() += 25;
+      (*decoupleVertices.get())[3] = (*vertices.get()).back();
+      (*decoupleVertices.get())[2] = (*vertices.get()).back();
+      (*decoupleVertices.get())[2].x() -= 25;
     }
     endOffset = startOffset = 0.0;
     updateWeightPos();
@@ -868,9 +987,14 @@ namespace osg_graph_viz {
       }
       hidden = false;
     }
+    applyFarZoom();
+    updateBatch();
+    view->updateEdgeBounds(this);
+    view->updateEdgeBundle(this);
   }
 
   void Edge::updateSmoothPos() {
+    if(!smoothVertices.valid()) return;
     int n = vertices->size()-1;
     (*smoothVertices.get())[0] = (*vertices.get())[0];
     (*smoothVertices.get())[1] = osg::Vec3((*vertices.get())[n].x(), (*vertices.get())[0].y(), 0);
@@ -897,6 +1021,7 @@ namespace osg_graph_viz {
 
   void Edge::setSmooth(bool v) {
     if(v && !smooth) {
+      createSmooth();
       if(!decoupled) {
         geode->removeDrawable(geom);
         geode->addDrawable(smoothGeom);
@@ -911,6 +1036,8 @@ namespace osg_graph_viz {
       smooth = false;
     }
     info["smooth"] = smooth;
+    updateBatch();
+    view->updateEdgeBounds(this);
   }
 
   void Edge::exportSvg(FILE *f, double ol, double ot)
@@ -938,7 +1065,7 @@ namespace osg_graph_viz {
     x2 = (*vertices.get())[n].x()-ol;
     y1 = -(*vertices.get())[0].y()+ot;
     y2 = -(*vertices.get())[n].y()+ot;
-    if((bool)info["decouple"]) {
+    if(decoupled) {
       x1 = (*decoupleVertices.get())[0].x()-ol;
       x2 = (*decoupleVertices.get())[1].x()-ol-x1;
       y1 = -(*decoupleVertices.get())[0].y()+ot;
@@ -972,8 +1099,8 @@ namespace osg_graph_viz {
       // fprintf(f, "\" id=\"%s\" inkscape:connector-type=\"polyline\" inkscape:connector-curvature=\"0\" inkscape:connection-start=\"#%s\" inkscape:connection-end=\"#%s\" sodipodi:nodetypes=\"cc\" />\n",
       //         edgeName.c_str(), fromNodePort.c_str(), toNodePort.c_str());
     }
-    if((double)info["weight"] > 1.0000001 ||
-       (double)info["weight"] < 0.9999999) {
+    if(weight.valid() &&
+       this->containsNode((osg::Node*)weight->getOSGNode())) {
       View::exportLabelToSvg(weight, f, -ol, ot);
     }
   }
@@ -1001,4 +1128,78 @@ namespace osg_graph_viz {
     }
   }
 
+  bool Edge::isInsideRectangle(double x1, double x2, double y1, double y2) {
+    // a smooth edge never leaves the box spanned by its end points
+    osg::Vec3Array *v = vertices.get();
+    if(decoupled) {
+      v = decoupleVertices.get();
+    }
+    for(size_t i=0; i<v->size(); ++i) {
+      if((*v)[i].x() < x1 || (*v)[i].x() > x2 ||
+         (*v)[i].y() < y1 || (*v)[i].y() > y2) {
+        return false;
+      }
+    }
+    return true;
+  }
+
+  void Edge::getPickBoxes(std::vector<PickBox> *boxes) {
+    boxes->clear();
+    if(hidden) return;
+    PickBox b;
+    if(smooth && !decoupled) {
+      // the area tested by checkMousePress including its minimal extent
+      osg::Vec3 start = (*smoothVertices.get())[0];
+      osg::Vec3 end = (*smoothVertices.get())[2];
+      b.x1 = std::min(start.x(), end.x()) - 10;
+      b.x2 = std::max(start.x(), end.x()) + 10;
+      b.y1 = std::min(start.y(), end.y()) - 10;
+      b.y2 = std::max(start.y(), end.y()) + 10;
+      boxes->push_back(b);
+      return;
+    }
+    if(decoupled) {
+      double left, right, top, bottom;
+      osg::Vec3Array *v = decoupleVertices.get();
+      b.x1 = b.x2 = (*v)[0].x();
+      b.y1 = b.y2 = (*v)[0].y();
+      for(size_t i=1; i<v->size(); ++i) {
+        b.x1 = std::min(b.x1, (double)(*v)[i].x());
+        b.x2 = std::max(b.x2, (double)(*v)[i].x());
+        b.y1 = std::min(b.y1, (double)(*v)[i].y());
+        b.y2 = std::max(b.y2, (double)(*v)[i].y());
+      }
+      decoupleIn->getRectangle(&left, &right, &top, &bottom);
+      b.x1 = std::min(b.x1, left);
+      b.x2 = std::max(b.x2, right);
+      b.y1 = std::min(b.y1, bottom);
+      b.y2 = std::max(b.y2, top);
+      decoupleOut->getRectangle(&left, &right, &top, &bottom);
+      b.x1 = std::min(b.x1, left);
+      b.x2 = std::max(b.x2, right);
+      b.y1 = std::min(b.y1, bottom);
+      b.y2 = std::max(b.y2, top);
+      b.x1 -= 2;
+      b.x2 += 2;
+      b.y1 -= 2;
+      b.y2 += 2;
+      boxes->push_back(b);
+      return;
+    }
+    osg::Vec3Array *v = vertices.get();
+    for(size_t i=0; i+1<v->size(); ++i) {
+      const osg::Vec3 &p1 = (*v)[i];
+      const osg::Vec3 &p2 = (*v)[i+1];
+      // checkMousePress accepts points inside an ellipse with the segment
+      // end points as foci; m covers its semi-minor axis
+      double l2 = (p2-p1).length();
+      double m = sqrt(0.125*l2 + 0.015625) + 1.0;
+      b.x1 = std::min(p1.x(), p2.x()) - m;
+      b.x2 = std::max(p1.x(), p2.x()) + m;
+      b.y1 = std::min(p1.y(), p2.y()) - m;
+      b.y2 = std::max(p1.y(), p2.y()) + m;
+      boxes->push_back(b);
+    }
+  }
+
 } // end of namespace: osg_graph_viz
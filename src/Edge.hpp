@@ -13,9 +13,14 @@
 #include <osg/PositionAttitudeTransform>
 #include <osg/LineWidth>
 
+#include <list>
+
 #include <configmaps/ConfigMap.hpp>
 #include <mars/osg_text/Text.h>
 
+#include "SegmentBVH.hpp"
+#include "EdgeBatch.hpp"
+
 namespace osg_material_manager {
   class OsgMaterialManager;
 }
@@ -25,6 +30,13 @@ namespace osg_graph_viz {
   class View;
   class Node;
 
+  // the port positions collected for an edge by the deferred update
+  struct EdgeEndPoints {
+    EdgeEndPoints() : hasStart(false), hasEnd(false) {}
+    bool hasStart, hasEnd;
+    osg::Vec3 start, end;
+  };
+
   class Edge : public osg::Group {
     friend class View;
 
@@ -37,11 +49,14 @@ namespace osg_graph_viz {
     void updateVPos(int i, osg::Vec3 v);
     void updateStartPos(osg::Vec3 v);
     void updateEndPos(osg::Vec3 v);
+    // moves both ends and updates the dependent parts only once
+    void updateEndPoints(const EdgeEndPoints &p);
     void setLineWidth(double w);
     void setColor(osg::Vec4 v);
     void setMiddlePos(double x);
     void mouseMove(double x, double y);
-    const configmaps::ConfigMap& getMap() {return info;}
+    // writes the current vertices into the map
+    const configmaps::ConfigMap& getMap();
     void setStartOffset(double v) {startOffset = v;}
     void setEndOffset(double v) {endOffset = v;}
     void setStartNode(osg_graph_viz::Node* node);
@@ -59,6 +74,7 @@ namespace osg_graph_viz {
     void decoupleEdge();
     void decouple(double threshhold);
     bool isDecoupled();
+    bool isHidden() {return hidden;}
     void derenderText(const bool readable);
     void reposition();
     void updateToNode(std::string nodeName, std::string portName);
@@ -68,29 +84,54 @@ namespace osg_graph_viz {
     void setSmooth(bool v);
     void exportSvg(FILE *f, double ol, double ot);
     void getRectangle(double *x1, double *x2, double *y1, double *y2);
+    // boxes around the parts checkMousePress() can hit
+    void getPickBoxes(std::vector<PickBox> *boxes);
+    bool isInsideRectangle(double x1, double x2, double y1, double y2);
+    // draws the polyline with the shared batch instead of the own geometry
+    void setEdgeBatch(EdgeBatch *batch);
+    // draws a straight line between the end points instead of the polyline
+    void setFarZoom(bool v);
 
   private:
     View *view;
     osg_material_manager::OsgMaterialManager *materialManager;
     osg::ref_ptr<osg::Uniform> startUniform, endUniform, colorUniform;
     configmaps::ConfigMap info;
-    osg::ref_ptr<osg::Geode> geode;
-    osg::ref_ptr<osg::Geometry> geom, decoupleGeom, smoothGeom;
+    osg::ref_ptr<osg::Geode> geode, straightGeode;
+    osg::ref_ptr<osg::Geometry> geom, decoupleGeom, smoothGeom, straightGeom;
     osg::ref_ptr<osg::LineWidth> linew;
+    osg::ref_ptr<EdgeBatch> edgeBatch;
     osg::ref_ptr<osg::Vec4Array> color;
     osg::ref_ptr<osg_graph_viz::Node> startNode, endNode;
     osg::ref_ptr<osg::Vec3Array> vertices, decoupleVertices, smoothVertices;
+    osg::ref_ptr<osg::Vec3Array> straightVertices;
     osg::ref_ptr<osg_text::Text> weight, decoupleIn, decoupleOut;
-    bool horizontal, selected, decoupled, smooth, hidden;
+    bool horizontal, selected, decoupled, smooth, hidden, textVisible, farZoom;
     int node;
     int fromIdx, toIdx; // used for decouple information only
     double startOffset, endOffset, startPos, endPos, offsetLimit;
     double dOffsetX, dOffsetY;
     double posOffsetX, posOffsetY;
+    unsigned long pickOrder;
+    // position in the edge list of the view
+    std::list<osg::ref_ptr<osg_graph_viz::Edge> >::iterator listHandle;
+    bool inEdgeList;
     void checkEndPositions();
+    void moveStart(osg::Vec3 v);
+    void moveEnd(osg::Vec3 v);
+    void updateParts();
+    void createDecouple();
+    // the decouple vertices for the current end points
+    void getDecoupleStubs(osg::Vec3 *v);
+    void createSmooth();
+    void createStraight();
+    void applyFarZoom();
+    void updateDecoupleLabels();
+    void updateWeight();
     void updateWeightPos();
     void updateDecouplePos();
     void updateSmoothPos();
+    void updateBatch();
   };
 
 } // end of namespace: osg_graph_viz
@@ -0,0 +1,157 @@
+/**
+ * \file EdgeBatch.cpp
+ * \brief Draws the polylines of many edges from a few shared vertex arrays.
+ */
+
+#include "EdgeBatch.hpp"
+
+namespace osg_graph_viz {
+
+  // number of vertices after which a new chunk is started
+  static const size_t chunkSize = 8192;
+
+  EdgeBatch::EdgeBatch() {
+    linew = new osg::LineWidth(1);
+    osg::StateSet *state = getOrCreateStateSet();
+    state->setAttributeAndModes(linew.get(), osg::StateAttribute::ON);
+    state->setMode(GL_BLEND, osg::StateAttribute::ON);
+    // the bin of the first nodes and edges created by the view
+    state->setRenderBinDetails(30, "RenderBin");
+  }
+
+  void EdgeBatch::update(Edge *edge, const osg::Vec3Array *vertices,
+                         const osg::Vec4 &color, bool visible) {
+    // the polyline is drawn as separate line segments
+    size_t count = vertices->size() > 1 ? 2*(vertices->size()-1) : 0;
+    std::unordered_map<Edge*, Range>::iterator it = ranges.find(edge);
+    if(it != ranges.end() && it->second.count != count) {
+      Range old = it->second;
+      ranges.erase(it);
+      release(edge, old);
+      it = ranges.end();
+    }
+    if(it == ranges.end()) {
+      it = ranges.insert(std::make_pair(edge, allocate(edge, count))).first;
+    }
+    const Range &r = it->second;
+    Chunk &c = chunks[r.chunk];
+    osg::Vec4 col = color;
+    if(!visible) col.a() = 0.0;
+    for(size_t i=0; i+1<vertices->size(); ++i) {
+      size_t k = r.first + 2*i;
+      if(visible) {
+        (*c.vertices)[k] = (*vertices)[i];
+        (*c.vertices)[k+1] = (*vertices)[i+1];
+      }
+      else {
+        (*c.vertices)[k] = (*c.vertices)[k+1] = (*vertices)[0];
+      }
+      (*c.colors)[k] = (*c.colors)[k+1] = col;
+    }
+    dirtyChunk(r.chunk);
+  }
+
+  void EdgeBatch::remove(Edge *edge) {
+    std::unordered_map<Edge*, Range>::iterator it = ranges.find(edge);
+    if(it == ranges.end()) return;
+    Range r = it->second;
+    ranges.erase(it);
+    release(edge, r);
+  }
+
+  bool EdgeBatch::contains(Edge *edge) const {
+    return ranges.find(edge) != ranges.end();
+  }
+
+  void EdgeBatch::setLineWidth(double w) {
+    linew->setWidth(w);
+  }
+
+  EdgeBatch::Range EdgeBatch::allocate(Edge *edge, size_t count) {
+    if(chunks.empty() ||
+       chunks.back().vertices->size() + count > chunkSize) {
+      Chunk c;
+      c.geom = new osg::Geometry;
+      c.geom->setDataVariance(osg::Object::DYNAMIC);
+      c.geom->setUseDisplayList(false);
+      c.geom->setUseVertexBufferObjects(true);
+      c.vertices = new osg::Vec3Array();
+      c.colors = new osg::Vec4Array();
+      c.geom->setVertexArray(c.vertices.get());
+      c.geom->setColorArray(c.colors.get());
+      c.geom->setColorBinding(osg::Geometry::BIND_PER_VERTEX);
+      osg::Vec3Array *normals = new osg::Vec3Array;
+      normals->push_back(osg::Vec3(0.0f, 0.0f, 1.0f));
+      c.geom->setNormalArray(normals);
+      c.geom->setNormalBinding(osg::Geometry::BIND_OVERALL);
+      c.drawArrays = new osg::DrawArrays(osg::PrimitiveSet::LINES, 0, 0);
+      c.geom->addPrimitiveSet(c.drawArrays.get());
+      c.waste = 0;
+      addDrawable(c.geom.get());
+      chunks.push_back(c);
+    }
+    Range r;
+    r.chunk = chunks.size()-1;
+    Chunk &c = chunks[r.chunk];
+    r.first = c.vertices->size();
+    r.count = count;
+    c.vertices->resize(r.first + count);
+    c.colors->resize(r.first + count);
+    c.edges.push_back(edge);
+    return r;
+  }
+
+  void EdgeBatch::release(Edge *edge, const Range &range) {
+    Chunk &c = chunks[range.chunk];
+    // collapse the segments until the chunk is compacted
+    for(size_t i=range.first; i<range.first+range.count; ++i) {
+      (*c.vertices)[i] = (*c.vertices)[range.first];
+      (*c.colors)[i] = osg::Vec4(0, 0, 0, 0);
+    }
+    for(size_t i=0; i<c.edges.size(); ++i) {
+      if(c.edges[i] == edge) {
+        c.edges[i] = c.edges.back();
+        c.edges.pop_back();
+        break;
+      }
+    }
+    c.waste += range.count;
+    if(2*c.waste > c.vertices->size()) {
+      compact(range.chunk);
+    }
+    dirtyChunk(range.chunk);
+  }
+
+  void EdgeBatch::compact(size_t chunk) {
+    Chunk &c = chunks[chunk];
+    osg::ref_ptr<osg::Vec3Array> vertices = new osg::Vec3Array();
+    osg::ref_ptr<osg::Vec4Array> colors = new osg::Vec4Array();
+    vertices->reserve(c.vertices->size() - c.waste);
+    colors->reserve(c.vertices->size() - c.waste);
+    for(size_t i=0; i<c.edges.size(); ++i) {
+      Range &r = ranges[c.edges[i]];
+      size_t first = vertices->size();
+      for(size_t k=r.first; k<r.first+r.count; ++k) {
+        vertices->push_back((*c.vertices)[k]);
+        colors->push_back((*c.colors)[k]);
+      }
+      r.first = first;
+    }
+    c.vertices = vertices;
+    c.colors = colors;
+    c.geom->setVertexArray(vertices.get());
+    c.geom->setColorArray(colors.get());
+    c.geom->setColorBinding(osg::Geometry::BIND_PER_VERTEX);
+    c.waste = 0;
+  }
+
+  void EdgeBatch::dirtyChunk(size_t chunk) {
+    Chunk &c = chunks[chunk];
+    c.drawArrays->setCount(c.vertices->size());
+    c.drawArrays->dirty();
+    c.vertices->dirty();
+    c.colors->dirty();
+    c.geom->dirtyBound();
+  }
+
+} // end of namespace: osg_graph_viz
@@ -0,0 +1,64 @@
+/**
+ * \file EdgeBatch.hpp
+ * \brief Draws the polylines of many edges from a few shared vertex arrays.
+ **/
+
+#ifndef OSG_GRAPH_VIZ_EDGE_BATCH_HPP
+#define OSG_GRAPH_VIZ_EDGE_BATCH_HPP
+
+#include <osg/Geode>
+#include <osg/Geometry>
+#include <osg/LineWidth>
+
+#include <vector>
+#include <unordered_map>
+
+namespace osg_graph_viz {
+
+  class Edge;
+
+  /**
+   * The polyline of every registered edge is stored as a range of line
+   * segments in one of several chunks. Each chunk is a geometry with its
+   * own vertex and color array, so moving an edge only uploads the arrays
+   * of its chunk. Ranges of removed edges are collapsed and reused once a
+   * chunk is compacted.
+   */
+  class EdgeBatch : public osg::Geode {
+
+  public:
+    EdgeBatch();
+
+    // writes the polyline of the edge and registers the edge if needed
+    void update(Edge *edge, const osg::Vec3Array *vertices,
+                const osg::Vec4 &color, bool visible);
+    void remove(Edge *edge);
+    bool contains(Edge *edge) const;
+    void setLineWidth(double w);
+
+  private:
+    struct Chunk {
+      osg::ref_ptr<osg::Geometry> geom;
+      osg::ref_ptr<osg::Vec3Array> vertices;
+      osg::ref_ptr<osg::Vec4Array> colors;
+      osg::ref_ptr<osg::DrawArrays> drawArrays;
+      std::vector<Edge*> edges;
+      size_t waste;
+    };
+    struct Range {
+      size_t chunk, first, count;
+    };
+
+    std::vector<Chunk> chunks;
+    std::unordered_map<Edge*, Range> ranges;
+    osg::ref_ptr<osg::LineWidth> linew;
+
+    Range allocate(Edge *edge, size_t count);
+    void release(Edge *edge, const Range &range);
+    void compact(size_t chunk);
+    void dirtyChunk(size_t chunk);
+  };
+
+} // end of namespace: osg_graph_viz
+
+#endif // OSG_GRAPH_VIZ_EDGE_BATCH_HPP
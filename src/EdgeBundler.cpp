@@ -0,0 +1,299 @@
+/**
+ * \file EdgeBundler.cpp
+ * \brief Merges the edges between the same node clusters into one bundle.
+ */
+
+#include "EdgeBundler.hpp"
+#include "Node.hpp"
+#include "Edge.hpp"
+
+#include <cmath>
+#include <algorithm>
+
+namespace osg_graph_viz {
+
+  // the size of a cluster cell on the screen
+  static const double cellPixels = 128.0;
+
+  static osg::Geometry* createGeometry(osg::Vec3Array *vertices,
+                                       osg::DrawArrays *drawArrays) {
+    osg::Geometry *geom = new osg::Geometry;
+    geom->setDataVariance(osg::Object::DYNAMIC);
+    geom->setUseDisplayList(false);
+    geom->setUseVertexBufferObjects(true);
+    geom->setVertexArray(vertices);
+    osg::Vec4Array *colors = new osg::Vec4Array;
+    colors->push_back(osg::Vec4(0.2, 0.2, 0.2, 0.6));
+    geom->setColorArray(colors);
+    geom->setColorBinding(osg::Geometry::BIND_OVERALL);
+    geom->addPrimitiveSet(drawArrays);
+    return geom;
+  }
+
+  EdgeBundler::EdgeBundler() : scale(1.0), scaleRatio(1.0),
+                               cellSize(cellPixels), changed(false) {
+    quadVertices = new osg::Vec3Array();
+    quadArrays = new osg::DrawArrays(osg::PrimitiveSet::QUADS, 0, 0);
+    quadGeom = createGeometry(quadVertices.get(), quadArrays.get());
+    addDrawable(quadGeom.get());
+    lineVertices = new osg::Vec3Array();
+    lineArrays = new osg::DrawArrays(osg::PrimitiveSet::LINES, 0, 0);
+    lineGeom = createGeometry(lineVertices.get(), lineArrays.get());
+    addDrawable(lineGeom.get());
+
+    osg::StateSet *state = getOrCreateStateSet();
+    state->setMode(GL_BLEND, osg::StateAttribute::ON);
+    state->setMode(GL_LIGHTING, osg::StateAttribute::OFF);
+    // below the flat nodes
+    state->setRenderBinDetails(19, "RenderBin");
+  }
+
+  osg_graph_viz::Node* EdgeBundler::getTopLevelNode(osg_graph_viz::Node *node) {
+    while(node->getParentNode().valid()) {
+      node = node->getParentNode().get();
+    }
+    return node;
+  }
+
+  int64_t EdgeBundler::getCell(osg_graph_viz::Node *node) {
+    double x1, x2, y1, y2;
+    node->getWorldRectangle(&x1, &x2, &y1, &y2);
+    int64_t x = (int64_t)floor(0.5*(x1+x2)/cellSize);
+    int64_t y = (int64_t)floor(0.5*(y1+y2)/cellSize);
+    return (int64_t)(((uint64_t)x << 32) ^ ((uint64_t)y & 0xffffffff));
+  }
+
+  void EdgeBundler::add(Edge *edge) {
+    osg_graph_viz::Node *start = edge->getStartNode();
+    osg_graph_viz::Node *end = edge->getEndNode();
+    osg_graph_viz::Node *from = start ? getTopLevelNode(start) : NULL;
+    osg_graph_viz::Node *to = end ? getTopLevelNode(end) : NULL;
+    std::unordered_map<Edge*, Entry>::iterator it = edgeKeys.find(edge);
+    // filtered and decoupled edges are left out like in the straight mode
+    if(!from || !to || from == to || edge->isHidden() || edge->isDecoupled()) {
+      if(it != edgeKeys.end()) remove(edge);
+      return;
+    }
+    Entry entry;
+    entry.start = start;
+    entry.end = end;
+    entry.from = from;
+    entry.to = to;
+    entry.key.from = getCell(from);
+    entry.key.to = getCell(to);
+    entry.key.local = (entry.key.from == entry.key.to);
+    if(entry.key.local) {
+      entry.key.from = (int64_t)(intptr_t)from;
+      entry.key.to = (int64_t)(intptr_t)to;
+    }
+    if(it != edgeKeys.end()) {
+      if(it->second.key == entry.key && it->second.start == start &&
+         it->second.end == end && it->second.from == from &&
+         it->second.to == to) {
+        bundles[entry.key].dirty = true;
+        changed = true;
+        return;
+      }
+      remove(edge);
+    }
+    insert(edge, entry);
+  }
+
+  void EdgeBundler::remove(Edge *edge) {
+    std::unordered_map<Edge*, Entry>::iterator it = edgeKeys.find(edge);
+    if(it == edgeKeys.end()) return;
+    Entry entry = it->second;
+    edgeKeys.erase(it);
+    erase(edge, entry);
+  }
+
+  void EdgeBundler::insert(Edge *edge, const Entry &entry) {
+    edgeKeys[edge] = entry;
+    link(entry.start, edge);
+    link(entry.end, edge);
+    changed = true;
+    std::unordered_map<Key, Bundle, KeyHash>::iterator bt = bundles.find(entry.key);
+    if(bt == bundles.end()) {
+      Bundle &bundle = bundles[entry.key];
+      bundle.edges.push_back(edge);
+      bundle.dirty = true;
+      addSlot(entry.key, bundle);
+      return;
+    }
+    Bundle &bundle = bt->second;
+    bundle.edges.push_back(edge);
+    bundle.dirty = true;
+    if(bundle.edges.size() == 2) {
+      // the single line becomes a quad
+      removeSlot(entry.key, bundle, 1);
+      addSlot(entry.key, bundle);
+    }
+  }
+
+  void EdgeBundler::erase(Edge *edge, const Entry &entry) {
+    unlink(entry.start, edge);
+    unlink(entry.end, edge);
+    changed = true;
+    Bundle &bundle = bundles[entry.key];
+    std::vector<Edge*> &edges = bundle.edges;
+    for(size_t i=0; i<edges.size(); ++i) {
+      if(edges[i] == edge) {
+        edges[i] = edges.back();
+        edges.pop_back();
+        break;
+      }
+    }
+    if(edges.empty()) {
+      removeSlot(entry.key, bundle, 1);
+      bundles.erase(entry.key);
+      return;
+    }
+    bundle.dirty = true;
+    if(edges.size() == 1) {
+      removeSlot(entry.key, bundle, 2);
+      addSlot(entry.key, bundle);
+    }
+  }
+
+  void EdgeBundler::link(osg_graph_viz::Node *node, Edge *edge) {
+    nodeEdges[node].push_back(edge);
+  }
+
+  void EdgeBundler::unlink(osg_graph_viz::Node *node, Edge *edge) {
+    std::vector<Edge*> &edges = nodeEdges[node];
+    for(size_t i=0; i<edges.size(); ++i) {
+      if(edges[i] == edge) {
+        edges[i] = edges.back();
+        edges.pop_back();
+        break;
+      }
+    }
+    if(edges.empty()) nodeEdges.erase(node);
+  }
+
+  void EdgeBundler::addSlot(const Key &key, Bundle &bundle) {
+    if(bundle.edges.size() == 1) {
+      bundle.slot = lineKeys.size();
+      lineKeys.push_back(key);
+      lineVertices->resize(2*lineKeys.size());
+    }
+    else {
+      bundle.slot = quadKeys.size();
+      quadKeys.push_back(key);
+      quadVertices->resize(4*quadKeys.size());
+    }
+  }
+
+  void EdgeBundler::removeSlot(const Key &key, const Bundle &bundle,
+                               size_t count) {
+    // count is the number of edges the slot was created for
+    std::vector<Key> &keys = count == 1 ? lineKeys : quadKeys;
+    osg::Vec3Array *vertices = count == 1 ? lineVertices.get() : quadVertices.get();
+    size_t n = count == 1 ? 2 : 4;
+    size_t slot = bundle.slot;
+    size_t last = keys.size()-1;
+    if(slot != last) {
+      keys[slot] = keys[last];
+      bundles[keys[slot]].slot = slot;
+      for(size_t i=0; i<n; ++i) {
+        (*vertices)[n*slot+i] = (*vertices)[n*last+i];
+      }
+    }
+    keys.pop_back();
+    vertices->resize(n*keys.size());
+  }
+
+  void EdgeBundler::nodeChanged(osg_graph_viz::Node *node) {
+    // the cells are only updated once per frame, the view reports the
+    // children of a moved or reparented node as well
+    movedNodes.insert(node);
+    changed = true;
+  }
+
+  void EdgeBundler::setScale(double scale, double scaleRatio) {
+    if(scale == this->scale && scaleRatio == this->scaleRatio) return;
+    this->scale = scale;
+    this->scaleRatio = scaleRatio;
+    double s = std::min(scale, scale*scaleRatio);
+    double size = pow(2.0, ceil(log2(cellPixels/s)));
+    if(size != cellSize) {
+      cellSize = size;
+      std::vector<Edge*> edges;
+      edges.reserve(edgeKeys.size());
+      std::unordered_map<Edge*, Entry>::iterator it;
+      for(it=edgeKeys.begin(); it!=edgeKeys.end(); ++it) {
+        edges.push_back(it->first);
+      }
+      for(size_t i=0; i<edges.size(); ++i) {
+        add(edges[i]);
+      }
+    }
+    // the width is given in screen pixels
+    std::unordered_map<Key, Bundle, KeyHash>::iterator it;
+    for(it=bundles.begin(); it!=bundles.end(); ++it) {
+      it->second.dirty = true;
+    }
+    changed = true;
+  }
+
+  void EdgeBundler::sync() {
+    if(!changed) return;
+    std::unordered_set<osg_graph_viz::Node*>::iterator nt;
+    for(nt=movedNodes.begin(); nt!=movedNodes.end(); ++nt) {
+      std::unordered_map<osg_graph_viz::Node*, std::vector<Edge*> >::iterator it;
+      it = nodeEdges.find(*nt);
+      if(it == nodeEdges.end()) continue;
+      std::vector<Edge*> edges = it->second;
+      for(size_t i=0; i<edges.size(); ++i) {
+        add(edges[i]);
+      }
+    }
+    movedNodes.clear();
+    std::unordered_map<Key, Bundle, KeyHash>::iterator it;
+    for(it=bundles.begin(); it!=bundles.end(); ++it) {
+      if(it->second.dirty) {
+        write(it->second);
+        it->second.dirty = false;
+      }
+    }
+    quadArrays->setCount(quadVertices->size());
+    quadArrays->dirty();
+    quadVertices->dirty();
+    quadGeom->dirtyBound();
+    lineArrays->setCount(lineVertices->size());
+    lineArrays->dirty();
+    lineVertices->dirty();
+    lineGeom->dirtyBound();
+    changed = false;
+  }
+
+  void EdgeBundler::write(const Bundle &bundle) {
+    size_t count = bundle.edges.size();
+    if(count == 1) {
+      size_t k = 2*bundle.slot;
+      (*lineVertices)[k] = bundle.edges[0]->getStartPosition();
+      (*lineVertices)[k+1] = bundle.edges[0]->getEndPosition();
+      return;
+    }
+    osg::Vec3 start, end;
+    for(size_t i=0; i<count; ++i) {
+      start += bundle.edges[i]->getStartPosition();
+      end += bundle.edges[i]->getEndPosition();
+    }
+    start /= count;
+    end /= count;
+
+    // offset the sides perpendicular to the bundle on the screen
+    double w = 0.5*std::min(sqrt((double)count), 16.0);
+    double sx = scale, sy = scale*scaleRatio;
+    osg::Vec3 d((end.x()-start.x())*sx, (end.y()-start.y())*sy, 0);
+    if(d.normalize() == 0) d = osg::Vec3(1, 0, 0);
+    osg::Vec3 n(-d.y()*w/sx, d.x()*w/sy, 0);
+    size_t k = 4*bundle.slot;
+    (*quadVertices)[k] = start - n;
+    (*quadVertices)[k+1] = end - n;
+    (*quadVertices)[k+2] = end + n;
+    (*quadVertices)[k+3] = start + n;
+  }
+
+} // end of namespace: osg_graph_viz
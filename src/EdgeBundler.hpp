@@ -0,0 +1,100 @@
+/**
+ * \file EdgeBundler.hpp
+ * \brief Merges the edges between the same node clusters into one bundle.
+ **/
+
+#ifndef OSG_GRAPH_VIZ_EDGE_BUNDLER_HPP
+#define OSG_GRAPH_VIZ_EDGE_BUNDLER_HPP
+
+#include <osg/Geode>
+#include <osg/Geometry>
+
+#include <vector>
+#include <unordered_map>
+#include <unordered_set>
+#include <stdint.h>
+
+namespace osg_graph_viz {
+
+  class Node;
+  class Edge;
+
+  /**
+   * The end nodes of an edge are replaced by their top level ancestors,
+   * which are clustered by a grid with cells of about cellPixels on the
+   * screen. Edges between two different cells are grouped by the pair of
+   * cells, edges inside of one cell by the pair of top level nodes, and
+   * edges inside of one top level node are not drawn. A group of several
+   * edges is drawn as one quad between the mean end points of its edges,
+   * its screen width grows with the square root of the number of edges. A
+   * single edge is drawn as a straight line between its ports. The cells
+   * only change when the zoom crosses a power of two, moved nodes re-sort
+   * their own edges and sync() rewrites the marked bundles.
+   */
+  class EdgeBundler : public osg::Geode {
+
+  public:
+    EdgeBundler();
+
+    // registers the edge or moves it to the bundle of its current end nodes
+    void add(Edge *edge);
+    void remove(Edge *edge);
+    // called whenever the bounds of the node have changed
+    void nodeChanged(osg_graph_viz::Node *node);
+    void setScale(double scale, double scaleRatio);
+    void sync();
+    size_t size() const {return quadKeys.size() + lineKeys.size();}
+
+  private:
+    struct Key {
+      // the ids are cell coordinates or, for local keys, node addresses
+      bool local;
+      int64_t from, to;
+      bool operator==(const Key &k) const {
+        return local == k.local && from == k.from && to == k.to;
+      }
+    };
+    struct KeyHash {
+      size_t operator()(const Key &k) const {
+        return std::hash<int64_t>()(k.from) ^ (std::hash<int64_t>()(k.to) << 1) ^ k.local;
+      }
+    };
+    struct Bundle {
+      std::vector<Edge*> edges;
+      size_t slot;
+      bool dirty;
+    };
+    struct Entry {
+      Key key;
+      // the end nodes of the edge and their top level ancestors
+      osg_graph_viz::Node *start, *end, *from, *to;
+    };
+
+    osg::ref_ptr<osg::Geometry> quadGeom, lineGeom;
+    osg::ref_ptr<osg::DrawArrays> quadArrays, lineArrays;
+    osg::ref_ptr<osg::Vec3Array> quadVertices, lineVertices;
+    std::unordered_map<Key, Bundle, KeyHash> bundles;
+    // the bundles in the order of their slots, single edges are lines
+    std::vector<Key> quadKeys, lineKeys;
+    std::unordered_map<Edge*, Entry> edgeKeys;
+    // the edges starting or ending at a node
+    std::unordered_map<osg_graph_viz::Node*, std::vector<Edge*> > nodeEdges;
+    // nodes whose edges are sorted again by the next sync()
+    std::unordered_set<osg_graph_viz::Node*> movedNodes;
+    double scale, scaleRatio, cellSize;
+    bool changed;
+
+    static osg_graph_viz::Node* getTopLevelNode(osg_graph_viz::Node *node);
+    int64_t getCell(osg_graph_viz::Node *node);
+    void insert(Edge *edge, const Entry &entry);
+    void erase(Edge *edge, const Entry &entry);
+    void link(osg_graph_viz::Node *node, Edge *edge);
+    void unlink(osg_graph_viz::Node *node, Edge *edge);
+    void addSlot(const Key &key, Bundle &bundle);
+    void removeSlot(const Key &key, const Bundle &bundle, size_t count);
+    void write(const Bundle &bundle);
+  };
+
+} // end of namespace: osg_graph_viz
+
+#endif // OSG_GRAPH_VIZ_EDGE_BUNDLER_HPP
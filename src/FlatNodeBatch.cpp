@@ -0,0 +1,84 @@
+/**
+ * \file FlatNodeBatch.cpp
+ * \brief Draws every node as one flat colored quad for the far zoom level.
+ */
+
+#include "FlatNodeBatch.hpp"
+
+namespace osg_graph_viz {
+
+  FlatNodeBatch::FlatNodeBatch() {
+    geom = new osg::Geometry;
+    geom->setDataVariance(osg::Object::DYNAMIC);
+    geom->setUseDisplayList(false);
+    geom->setUseVertexBufferObjects(true);
+    vertices = new osg::Vec3Array();
+    colors = new osg::Vec4Array();
+    geom->setVertexArray(vertices.get());
+    geom->setColorArray(colors.get());
+    geom->setColorBinding(osg::Geometry::BIND_PER_VERTEX);
+    drawArrays = new osg::DrawArrays(osg::PrimitiveSet::QUADS, 0, 0);
+    geom->addPrimitiveSet(drawArrays.get());
+    addDrawable(geom.get());
+
+    osg::StateSet *state = getOrCreateStateSet();
+    state->setMode(GL_BLEND, osg::StateAttribute::ON);
+    state->setMode(GL_LIGHTING, osg::StateAttribute::OFF);
+    // below the nodes and edges, their bins start at 30
+    state->setRenderBinDetails(20, "RenderBin");
+  }
+
+  void FlatNodeBatch::update(Node *node, double x1, double x2,
+                             double y1, double y2, const osg::Vec4 &color) {
+    size_t slot;
+    std::unordered_map<Node*, size_t>::iterator it = slots.find(node);
+    if(it == slots.end()) {
+      slot = nodes.size();
+      slots[node] = slot;
+      nodes.push_back(node);
+      vertices->resize(4*nodes.size());
+      colors->resize(4*nodes.size());
+    }
+    else {
+      slot = it->second;
+    }
+    size_t n = 4*slot;
+    (*vertices)[n] = osg::Vec3(x1, y1, 0);
+    (*vertices)[n+1] = osg::Vec3(x2, y1, 0);
+    (*vertices)[n+2] = osg::Vec3(x2, y2, 0);
+    (*vertices)[n+3] = osg::Vec3(x1, y2, 0);
+    for(size_t i=0; i<4; ++i) {
+      (*colors)[n+i] = color;
+    }
+    dirtyArrays();
+  }
+
+  void FlatNodeBatch::remove(Node *node) {
+    std::unordered_map<Node*, size_t>::iterator it = slots.find(node);
+    if(it == slots.end()) return;
+    size_t slot = it->second;
+    size_t last = nodes.size()-1;
+    if(slot != last) {
+      nodes[slot] = nodes[last];
+      slots[nodes[slot]] = slot;
+      for(size_t i=0; i<4; ++i) {
+        (*vertices)[4*slot+i] = (*vertices)[4*last+i];
+        (*colors)[4*slot+i] = (*colors)[4*last+i];
+      }
+    }
+    slots.erase(node);
+    nodes.pop_back();
+    vertices->resize(4*nodes.size());
+    colors->resize(4*nodes.size());
+    dirtyArrays();
+  }
+
+  void FlatNodeBatch::dirtyArrays() {
+    drawArrays->setCount(vertices->size());
+    drawArrays->dirty();
+    vertices->dirty();
+    colors->dirty();
+    geom->dirtyBound();
+  }
+
+} // end of namespace: osg_graph_viz
@@ -0,0 +1,49 @@
+/**
+ * \file FlatNodeBatch.hpp
+ * \brief Draws every node as one flat colored quad for the far zoom level.
+ **/
+
+#ifndef OSG_GRAPH_VIZ_FLAT_NODE_BATCH_HPP
+#define OSG_GRAPH_VIZ_FLAT_NODE_BATCH_HPP
+
+#include <osg/Geode>
+#include <osg/Geometry>
+
+#include <vector>
+#include <unordered_map>
+
+namespace osg_graph_viz {
+
+  class Node;
+
+  /**
+   * Every registered node owns four vertices of one quad geometry holding
+   * its world rectangle and body color. Like in the RoundBodyBatch the
+   * last slot is moved into the slot of a removed node, so the whole graph
+   * is drawn with a single draw call.
+   */
+  class FlatNodeBatch : public osg::Geode {
+
+  public:
+    FlatNodeBatch();
+
+    // writes the quad of the node and registers the node if needed
+    void update(Node *node, double x1, double x2, double y1, double y2,
+                const osg::Vec4 &color);
+    void remove(Node *node);
+    size_t size() const {return nodes.size();}
+
+  private:
+    osg::ref_ptr<osg::Geometry> geom;
+    osg::ref_ptr<osg::DrawArrays> drawArrays;
+    osg::ref_ptr<osg::Vec3Array> vertices;
+    osg::ref_ptr<osg::Vec4Array> colors;
+    std::vector<Node*> nodes;
+    std::unordered_map<Node*, size_t> slots;
+
+    void dirtyArrays();
+  };
+
+} // end of namespace: osg_graph_viz
+
+#endif // OSG_GRAPH_VIZ_FLAT_NODE_BATCH_HPP
@@ -12,6 +12,7 @@
 #include <osg/LineWidth>
 #include <cstdio>
 #include <configmaps/ConfigData.h>
+#include <mars/utils/misc.h>
 
 #include <osg/Texture2D>
 #include <osgDB/ReadFile>
@@ -25,6 +26,39 @@ using namespace configmaps;
 
 namespace osg_graph_viz {
 
+  static void setFold(PortDescriptor *port, int num) {
+    port->hasFold = true;
+    port->foldNum = num;
+    port->foldState = 0;
+  }
+
+  static void parsePorts(ConfigMap &map, const std::string &tag, size_t num,
+                         bool ownDomain, std::vector<PortDescriptor> *ports) {
+    size_t size = map.hasKey(tag) ? map[tag].size() : 0;
+    // missing entries keep the zero initialized defaults
+    ports->clear();
+    ports->resize(std::max(num, size));
+    for(size_t i=0; i<size; ++i) {
+      ConfigItem &item = map[tag][i];
+      PortDescriptor &port = (*ports)[i];
+      if(item.hasKey("name")) port.name << item["name"];
+      if(item.hasKey("type")) port.type << item["type"];
+      if(item.hasKey("alias")) port.alias << item["alias"];
+      if(item.hasKey("direction")) port.direction << item["direction"];
+      if(ownDomain && item.hasKey("domain")) {
+        port.domain = mars::utils::tolower(item["domain"]);
+      }
+      port.bias = item.hasKey("bias") ? (double)item["bias"] : 0.0;
+      port.def = item.hasKey("default") ? (double)item["default"] : 0.0;
+      port.interface = item.hasKey("interface") ? (int)item["interface"] : 0;
+      port.hasFold = item.hasKey("fold");
+      if(port.hasFold) {
+        port.foldState = item["fold"]["state"];
+        port.foldNum = item["fold"]["num"];
+      }
+    }
+  }
+
   std::string Node::replaceString(const std::string &source,
                                   const std::string &s1,
                                   const std::string &s2) {
@@ -42,6 +76,7 @@ namespace osg_graph_viz {
   }
 
   Node::Node(const NodeInfo &info_, View *v) : info(info_), view(v) {
+    parseDescriptor();
     init();
     initContent();
   }
@@ -59,6 +94,7 @@ namespace osg_graph_viz {
     selected = false;
     ignoreNextInPort = false;
     ignoreNextOutPort = false;
+    layoutDeferred = layoutDirty = false;
     pos = new osg::PositionAttitudeTransform();
     pos2 = new osg::PositionAttitudeTransform();
     children = new osg::MatrixTransform();
@@ -72,6 +108,65 @@ namespace osg_graph_viz {
     state->setMode(GL_BLEND, osg::StateAttribute::OFF);
     state->setMode(GL_FOG, osg::StateAttribute::OFF);
     posX = posY = 0.0;
+    pickOrder = 0;
+    inNodeList = false;
+    textVisible = true;
+  }
+
+  void Node::parseDescriptor() {
+    desc.name = desc.type = "";
+    if(info.map.hasKey("name")) desc.name << info.map["name"];
+    if(info.map.hasKey("type")) desc.type << info.map["type"];
+    if(desc.type == "INPUT") desc.kind = NODE_KIND_INPUT;
+    else if(desc.type == "OUTPUT") desc.kind = NODE_KIND_OUTPUT;
+    else if(desc.type == "DES") desc.kind = NODE_KIND_DES;
+    else if(desc.type == "META") desc.kind = NODE_KIND_META;
+    else desc.kind = NODE_KIND_DEFAULT;
+
+    desc.domainName = "";
+    if(info.map.hasKey("domain")) {
+      desc.domainName = mars::utils::tolower(info.map["domain"]);
+    }
+    const std::string &domain = desc.domainName;
+    if(domain.empty()) desc.domain = NODE_DOMAIN_NONE;
+    else if(domain == "software") desc.domain = NODE_DOMAIN_SOFTWARE;
+    else if(domain == "assembly") desc.domain = NODE_DOMAIN_ASSEMBLY;
+    else if(domain == "electronics") desc.domain = NODE_DOMAIN_ELECTRONICS;
+    else if(domain == "mechanics") desc.domain = NODE_DOMAIN_MECHANICS;
+    else if(domain == "behavior") desc.domain = NODE_DOMAIN_BEHAVIOR;
+    else if(domain == "computation") desc.domain = NODE_DOMAIN_COMPUTATION;
+    else desc.domain = NODE_DOMAIN_OTHER;
+
+    // only the ports of assembly nodes have their own domain
+    bool ownDomain = desc.domain == NODE_DOMAIN_ASSEMBLY;
+    parsePorts(info.map, "inputs", std::max(info.numInputs, 0), ownDomain,
+               &desc.inputs);
+    parsePorts(info.map, "outputs", std::max(info.numOutputs, 0), ownDomain,
+               &desc.outputs);
+  }
+
+  void Node::writeMap() {
+    info.map["pos"]["x"] = posX;
+    info.map["pos"]["y"] = posY;
+    writeFolds("inputs", desc.inputs);
+    writeFolds("outputs", desc.outputs);
+  }
+
+  void Node::writeFolds(const std::string &tag,
+                        const std::vector<PortDescriptor> &ports) {
+    if(!info.map.hasKey(tag)) return;
+    size_t size = info.map[tag].size();
+    for(size_t i=0; i<ports.size() && i<size; ++i) {
+      if(ports[i].hasFold) {
+        info.map[tag][i]["fold"]["num"] = ports[i].foldNum;
+        info.map[tag][i]["fold"]["state"] = ports[i].foldState;
+      }
+    }
+  }
+
+  const ConfigMap& Node::getMap() {
+    writeMap();
+    return info.map;
   }
 
   void Node::initContent() {
@@ -85,8 +180,8 @@ namespace osg_graph_viz {
     if(info.numOutputs > maxPorts) {
       maxPorts = info.numOutputs;
     }
-    if((std::string)info.map["type"] == "INPUT" ||
-       (std::string)info.map["type"] == "OUTPUT") {
+    if(desc.kind == NODE_KIND_INPUT ||
+       desc.kind == NODE_KIND_OUTPUT) {
       headerHeight = 0;
       height = std::max(portSpaceY - 2.0, headerFontSize + 2.0);
       namePosY = -(height - headerFontSize) / 2.0;
@@ -107,40 +202,40 @@ namespace osg_graph_viz {
     colorMap["META"].push_back(osg::Vec4(1.0, 0.5, 0.5, 1.0));
     colorMap["META"].push_back(osg::Vec4(1.0, .6, 0.6, 1.0));
 
-    bGeode = createBody(width, height, 0, 0, info.map["type"]);
+    bGeode = createBody(width, height, 0, 0, desc.type);
     pos->addChild(bGeode);
 
     osg_text::Color c(0., 0., 0., 1.0);
 
     namePosX = width*0.5;
     osg_text::TextAlign align = osg_text::ALIGN_CENTER;
-    if((std::string)info.map["type"] == "OUTPUT") {
+    if(desc.kind == NODE_KIND_OUTPUT) {
       namePosX = 5+mergeIconSize / 2.0;
       align = osg_text::ALIGN_LEFT;
     }
-    else if((std::string)info.map["type"] == "INPUT") {
+    else if(desc.kind == NODE_KIND_INPUT) {
       namePosX = 5;
       align = osg_text::ALIGN_LEFT;
     }
-    nodeName = new osg_text::Text((std::string)info.map["name"], headerFontSize, c,
+    nodeName = new osg_text::Text(desc.name, headerFontSize, c,
                                   namePosX, namePosY, align, 0, 0, 0, 0,
                                   osg_text::Color(), osg_text::Color(),
                                   0, view->getResourcesPath()+"/fonts/stilu/Stilu-Light.ttf");
 
-    if((std::string)info.map["type"] == "INPUT" ||
-       (std::string)info.map["type"] == "OUTPUT") {
-      nodeName->setText((std::string)info.map["name"]);
+    if(desc.kind == NODE_KIND_INPUT ||
+       desc.kind == NODE_KIND_OUTPUT) {
+      nodeName->setText(desc.name);
     }
     else {
-      nodeName->setText("[ " + (std::string)info.map["type"] + " ]  " + (std::string)info.map["name"]);
+      nodeName->setText("[ " + desc.type + " ]  " + desc.name);
     }
     nodeName->setBackgroundColor(osg_text::Color(0.0, 0.0, 0.0, 0.0));
     pos->addChild((osg::Node*)nodeName->getOSGNode());
 
-    if((std::string)info.map["type"] == "DES"){
+    if(desc.kind == NODE_KIND_DES){
       handleDescription();
     }
-    else if((std::string)info.map["type"] == "META"){
+    else if(desc.kind == NODE_KIND_META){
       handleMeta();
     }
 
@@ -163,11 +258,9 @@ namespace osg_graph_viz {
     // handle the inputs
     for(int i=0; i<info.numInputs; ++i) {
       double portPosY = portStartY - portSpaceY*(portCnt);
-      std::string name = (std::string)info.map["inputs"][i]["name"];
-      int interface = 0;
-      if(info.map["inputs"][i].hasKey("interface")) {
-        interface = info.map["inputs"][i]["interface"];
-      }
+      const PortDescriptor &port = desc.inputs[i];
+      std::string name = port.name;
+      int interface = port.interface;
       Port *p;
       if(update) {
         p = inPorts[i];
@@ -180,7 +273,7 @@ namespace osg_graph_viz {
         }
         std::list<osg::ref_ptr<Edge> >::iterator it = p->edges.begin();
         for(; it!=p->edges.end(); ++it) {
-          (*it)->updateToNode((std::string)info.map["name"], name);
+          (*it)->updateToNode(desc.name, name);
         }
       }
       else {
@@ -193,9 +286,9 @@ namespace osg_graph_viz {
       p->portPos = portCnt;
 
       if(f2 == 0) {
-        if(info.map["inputs"][i].hasKey("fold")) {
-          foldState = info.map["inputs"][i]["fold"]["state"];
-          f2 = info.map["inputs"][i]["fold"]["num"];
+        if(port.hasFold) {
+          foldState = port.foldState;
+          f2 = port.foldNum;
           f3 = 0;
           foldPort = p;
           f1 = 0;
@@ -203,8 +296,8 @@ namespace osg_graph_viz {
       }
       if(f3 == 0 || foldState == 0) {
         std::string image = "images/OutPort.png";
-        if(mergeImages.find(info.map["inputs"][i]["type"]) != mergeImages.end()) {
-          image = mergeImages[info.map["inputs"][i]["type"]];
+        if(mergeImages.find(port.type) != mergeImages.end()) {
+          image = mergeImages[port.type];
         }
         osg::Geode *g = createRect(portScale*mergeIconSize, portScale*mergeIconSize, -(portScale*mergeIconSize)/2.0, portPosY - (portScale*mergeIconSize)/2.0, image);
         ++maxPorts;
@@ -258,12 +351,10 @@ namespace osg_graph_viz {
                                    "images/Fold.png");
         foldPort->foldIcon = g;
         pos->addChild(g);
-        info.map["inputs"][foldPortIndex]["fold"]["num"] = 3;
-        info.map["inputs"][foldPortIndex]["fold"]["state"] = 0;
+        setFold(&desc.inputs[foldPortIndex], 3);
       }
       else if(f1==4) {
-        info.map["inputs"][foldPortIndex]["fold"]["num"] = 4;
-        info.map["inputs"][foldPortIndex]["fold"]["state"] = 0;
+        setFold(&desc.inputs[foldPortIndex], 4);
       }
       else if(f3==0 && f2 > 0) {
         osg::Geode *g = createRect(foldIconSize, foldIconSize, mergeIconSize/2.0, portPosY + mergeIconSize/2.0,
@@ -273,13 +364,13 @@ namespace osg_graph_viz {
       }
 
       if(!update) {
-        double b = info.map["inputs"][i]["bias"];
+        double b = port.bias;
         bool print = true;
-        if((std::string)info.map["inputs"][i]["type"] == "SUM" &&
+        if(port.type == "SUM" &&
            fabs(b) < 0.0000001) {
           print = false;
         }
-        else if((std::string)info.map["inputs"][i]["type"] == "PRODUCT" &&
+        else if(port.type == "PRODUCT" &&
                 fabs(1-b) < 0.0000001) {
           print = false;
         }
@@ -288,7 +379,7 @@ namespace osg_graph_viz {
         if(print) {
           sprintf(bias, "[b%g] ", b);
         }
-        sprintf(def, "[d%g] ", (double)info.map["inputs"][i]["default"]);
+        sprintf(def, "[d%g] ", port.def);
         osg_text::Text *t = new osg_text::Text(std::string(bias)+def+name,
                                                portFontSize, c, 0.0,
                                                portPosY + portFontSize/2.0,
@@ -341,12 +432,10 @@ namespace osg_graph_viz {
     portCnt = foldPortCnt = 0;
     for(int i=0; i<info.numOutputs; ++i) {
       double portPosY = portStartY - portSpaceY*(portCnt);
-      std::string name = (std::string)info.map["outputs"][i]["name"];
+      const PortDescriptor &port = desc.outputs[i];
+      std::string name = port.name;
       Port *p;
-      int interface = 0;
-      if(info.map["outputs"][i].hasKey("interface")) {
-        interface = info.map["outputs"][i]["interface"];
-      }
+      int interface = port.interface;
       if(update) {
         p = outPorts[i];
         if(p->foldIcon.valid()) {
@@ -356,7 +445,7 @@ namespace osg_graph_viz {
         pos->removeChild((osg::Node*)p->labels[0]->getOSGNode());
         std::list<osg::ref_ptr<Edge> >::iterator it = p->edges.begin();
         for(; it!=p->edges.end(); ++it) {
-          (*it)->updateFromNode((std::string)info.map["name"], name);
+          (*it)->updateFromNode(desc.name, name);
         }
       }
       else {
@@ -368,9 +457,9 @@ namespace osg_graph_viz {
       p->foldPort = 0;
       p->portPos = portCnt;
       if(f2 == 0) {
-        if(info.map["outputs"][i].hasKey("fold")) {
-          foldState = info.map["outputs"][i]["fold"]["state"];
-          f2 = info.map["outputs"][i]["fold"]["num"];
+        if(port.hasFold) {
+          foldState = port.foldState;
+          f2 = port.foldNum;
           f3 = 0;
           foldPort = p;
           f1 = 0;
@@ -430,12 +519,10 @@ namespace osg_graph_viz {
                                    "images/Fold.png");
         foldPort->foldIcon = g;
         pos->addChild(g);
-        info.map["outputs"][foldPortIndex]["fold"]["num"] = 3;
-        info.map["outputs"][foldPortIndex]["fold"]["state"] = 0;
+        setFold(&desc.outputs[foldPortIndex], 3);
       }
       else if(f1==4) {
-        info.map["outputs"][foldPortIndex]["fold"]["num"] = 4;
-        info.map["outputs"][foldPortIndex]["fold"]["state"] = 0;
+        setFold(&desc.outputs[foldPortIndex], 4);
       }
       else if(f3==0 && f2 > 0) {
         osg::Geode *g = createRect(foldIconSize, foldIconSize, width - mergeIconSize/2.0 - foldIconSize, portPosY + mergeIconSize/2.0,
@@ -495,6 +582,7 @@ namespace osg_graph_viz {
     if(numOutPorts > maxPorts) {
       maxPorts = numOutPorts;
     }
+    if(!textVisible) derenderText(false);
     resizeHeight();
   }
 
@@ -555,9 +643,8 @@ namespace osg_graph_viz {
     // vertices->at(9).y() = -height;
     // vertices->at(6).y() = -height;
     // vertices->at(10).y() = -height;
-    bGeom->dirtyDisplayList();
-    bGeom->dirtyBound();
     vertices->dirty();
+    bGeom->dirtyBound();
   }
 
   void Node::handleMeta(){
@@ -579,9 +666,8 @@ namespace osg_graph_viz {
     vertices->at(9).y() = -height;
     vertices->at(6).y() = -height;
     vertices->at(10).y() = -height;
-    bGeom->dirtyDisplayList();
-    bGeom->dirtyBound();
     vertices->dirty();
+    bGeom->dirtyBound();
   }
 
   void Node::setLineWidth(double w) {
@@ -647,11 +733,10 @@ namespace osg_graph_viz {
       if(posY>maxY) posY = maxY;
       parent->updateSize();
     }
-    info.map["pos"]["x"] = posX;
-    info.map["pos"]["y"] = posY;
     pos->setPosition(osg::Vec3(posX, posY, 0.0));
     pos2->setPosition(osg::Vec3(posX, posY, 0.0));
     updateEdges();
+    updateBounds();
   }
 
   double Node::getMaxChildY() {
@@ -661,14 +746,14 @@ namespace osg_graph_viz {
   double Node::getMinChildX() {
     double x1, x2, y1, y2;
     double x = 0;
-    if((std::string)info.map["type"] == "OUTPUT") {
+    if(desc.kind == NODE_KIND_OUTPUT) {
       inPorts[0]->labels[0]->getRectangle(&x1, &x2, &y1, &y2);
       x = x2-x1;
     }
-    else if((std::string)info.map["type"] == "DES") {
+    else if(desc.kind == NODE_KIND_DES) {
       // the description nodes are handled differently
       return x;
-    } else if((std::string)info.map["type"] == "META") {
+    } else if(desc.kind == NODE_KIND_META) {
       // the meta nodes are handled differently
       return x;
     } else {
@@ -689,23 +774,38 @@ namespace osg_graph_viz {
   }
 
   void Node::updateEdges() {
+    // collected by the view and applied once per frame while dragging
+    if(view->deferEdgeUpdate(this)) return;
+    std::unordered_map<Edge*, EdgeEndPoints> points;
+    getEdgeEndPoints(&points);
+    std::unordered_map<Edge*, EdgeEndPoints>::iterator it;
+    for(it=points.begin(); it!=points.end(); ++it) {
+      it->first->updateEndPoints(it->second);
+    }
+  }
+
+  void Node::getEdgeEndPoints(std::unordered_map<Edge*, EdgeEndPoints> *points) {
     for(size_t i=0; i<inPorts.size(); ++i) {
       std::list<osg::ref_ptr<Edge> >::iterator it;
       for(it=inPorts[i]->edges.begin(); it!=inPorts[i]->edges.end(); ++it) {
-        (*it)->updateEndPos(getInPortPos(i));
+        EdgeEndPoints &p = (*points)[it->get()];
+        p.hasEnd = true;
+        p.end = getInPortPos(i);
       }
     }
 
     for(size_t i=0; i<outPorts.size(); ++i) {
       std::list<osg::ref_ptr<Edge> >::iterator it;
       for(it=outPorts[i]->edges.begin(); it!=outPorts[i]->edges.end(); ++it) {
-        (*it)->updateStartPos(getOutPortPos(i));
+        EdgeEndPoints &p = (*points)[it->get()];
+        p.hasStart = true;
+        p.start = getOutPortPos(i);
       }
     }
     for(size_t i=0; i<children->getNumChildren(); ++i) {
       osg_graph_viz::Node *node = dynamic_cast<osg_graph_viz::Node*>(children->getChild(i));
       if(node) {
-        node->updateEdges();
+        node->getEdgeEndPoints(points);
       }
     }
   }
@@ -719,6 +819,7 @@ namespace osg_graph_viz {
     posY += y;
     pos->setPosition(osg::Vec3(posX, posY, 0.0));
     pos2->setPosition(osg::Vec3(posX, posY, 0.0));
+    updateBounds();
   }
 
   void Node::getPosOffset(double x, double y, double *ox, double *oy) {
@@ -804,8 +905,8 @@ namespace osg_graph_viz {
     }
     // restore position
     setAbsolutePosition(x, y);
-    m["pos"]["x"] = info.map["pos"]["x"];
-    m["pos"]["y"] = info.map["pos"]["y"];
+    m["pos"]["x"] = posX;
+    m["pos"]["y"] = posY;
   }
   else {
     info.map["parentName"] = "";
@@ -820,25 +921,29 @@ namespace osg_graph_viz {
 
   void Node::updateMap(const ConfigMap &map_) {
     ConfigMap map = map_;
+    std::string oldName = getName();
     updateParentFromMap(map);
     info.map = map;
+    parseDescriptor();
+    view->updateNodeName(oldName, this);
     setPosition(info.map["pos"]["x"], info.map["pos"]["y"]);
-    if((std::string)info.map["type"] == "INPUT" ||
-       (std::string)info.map["type"] == "OUTPUT") {
-      nodeName->setText((std::string)info.map["name"]);
+    if(desc.kind == NODE_KIND_INPUT ||
+       desc.kind == NODE_KIND_OUTPUT) {
+      nodeName->setText(desc.name);
     }
     else {
-      nodeName->setText("[ " + (std::string)info.map["type"] + " ]  " + (std::string)info.map["name"]);
+      nodeName->setText("[ " + desc.type + " ]  " + desc.name);
     }
     for(size_t i=0; i<inPorts.size(); ++i) {
-      double b = info.map["inputs"][i]["bias"];
-      double d = info.map["inputs"][i]["default"];
+      const PortDescriptor &port = desc.inputs[i];
+      double b = port.bias;
+      double d = port.def;
       bool print = true;
-      if((std::string)info.map["inputs"][i]["type"] == "SUM" &&
+      if(port.type == "SUM" &&
          fabs(b) < 0.0000001) {
         print = false;
       }
-      else if((std::string)info.map["inputs"][i]["type"] == "PRODUCT" &&
+      else if(port.type == "PRODUCT" &&
               fabs(1-b) < 0.0000001) {
         print = false;
       }
@@ -852,19 +957,17 @@ namespace osg_graph_viz {
       if(inPorts[i]->edges.size() == 0) {
         sprintf(def, "[d%g] ", d);
       }
-      std::string name = (std::string)info.map["inputs"][i]["name"];
-      inPorts[i]->labels[0]->setText((std::string)bias+def+name);
+      inPorts[i]->labels[0]->setText((std::string)bias+def+port.name);
     }
     for(size_t i=0; i<outPorts.size(); ++i) {
-      std::string name = (std::string)info.map["outputs"][i]["name"];
-      outPorts[i]->labels[0]->setText((std::string)name);
+      outPorts[i]->labels[0]->setText(desc.outputs[i].name);
     }
     double x1, x2, y1, y2;
     nodeName->getRectangle(&x1, &x2, &y1, &y2);
-    if((std::string)info.map["type"] == "DES"){
+    if(desc.kind == NODE_KIND_DES){
       handleDescription();
     }
-    else if((std::string)info.map["type"] == "META"){
+    else if(desc.kind == NODE_KIND_META){
       handleMeta();
     }
     updateSize();
@@ -874,13 +977,14 @@ namespace osg_graph_viz {
   void Node::addInputEdge(int index, Edge* edge) {
     //edge->setEndOffset(portOffsets[inPorts[index]->edges.size()%3]);
     inPorts[index]->edges.push_back(edge);
-    double b = info.map["inputs"][index]["bias"];
+    const PortDescriptor &port = desc.inputs[index];
+    double b = port.bias;
     bool print = true;
-    if((std::string)info.map["inputs"][index]["type"] == "SUM" &&
+    if(port.type == "SUM" &&
        fabs(b) < 0.0000001) {
       print = false;
     }
-    else if((std::string)info.map["inputs"][index]["type"] == "PRODUCT" &&
+    else if(port.type == "PRODUCT" &&
             fabs(1-b) < 0.0000001) {
       print = false;
     }
@@ -889,18 +993,32 @@ namespace osg_graph_viz {
     if(print) {
       sprintf(bias, "[b%g] ", b);
     }
-    std::string name = (std::string)info.map["inputs"][index]["name"];
-    inPorts[index]->labels[0]->setText(bias+name);
+    inPorts[index]->labels[0]->setText(bias+port.name);
     edge->setEndNode(this);
-    resizeWidth();
-    handlePorts(true);
+    if(layoutDeferred) layoutDirty = true;
+    else if(!view->deferLayout(this)) relayout();
   }
 
   void Node::addOutputEdge(int index, Edge* edge) {
     //edge->setStartOffset(portOffsets[outPorts[index]->edges.size()%3]);
     outPorts[index]->edges.push_back(edge);
     edge->setStartNode(this);
-    updateEdges();
+    if(layoutDeferred) layoutDirty = true;
+    else updateEdges();
+  }
+
+  void Node::relayout() {
+    resizeWidth();
+    handlePorts(true);
+  }
+
+  void Node::setLayoutDeferred(bool v) {
+    layoutDeferred = v;
+    if(!v && layoutDirty) {
+      layoutDirty = false;
+      relayout();
+      updateEdges();
+    }
   }
 
   void Node::removeOutputEdge(Edge *edge) {
@@ -1010,10 +1128,7 @@ namespace osg_graph_viz {
           //fprintf(stderr, "fold in check: %g-%g / %g-%g\n", foldIconCornerX, foldIconCornerX + foldIconSize, foldIconCornerY, foldIconCornerY + foldIconSize);
           if(x > foldIconCornerX && x < foldIconCornerX + foldIconSize) {
             if(y > foldIconCornerY  && foldIconCornerY + foldIconSize) {
-              int state = info.map["inputs"][i]["fold"]["state"];
-              state++;
-              state %= 2;
-              info.map["inputs"][i]["fold"]["state"] = state;
+              desc.inputs[i].foldState = (desc.inputs[i].foldState+1) % 2;
               handlePorts(true);
               updateEdges();
               ignoreNextInPort = true;
@@ -1033,10 +1148,7 @@ namespace osg_graph_viz {
           //fprintf(stderr, "fold out check: %g-%g / %g-%g\n", foldIconCornerX, foldIconCornerX + foldIconSize, foldIconCornerY, foldIconCornerY + foldIconSize);
           if(x > foldIconCornerX && x < foldIconCornerX + foldIconSize) {
             if(y > foldIconCornerY  && foldIconCornerY + foldIconSize) {
-              int state = info.map["outputs"][i]["fold"]["state"];
-              state++;
-              state %= 2;
-              info.map["outputs"][i]["fold"]["state"] = state;
+              desc.outputs[i].foldState = (desc.outputs[i].foldState+1) % 2;
               handlePorts(true);
               updateEdges();
               ignoreNextInPort = true;
@@ -1355,8 +1467,8 @@ namespace osg_graph_viz {
   void Node::setSelected(bool b) {
     selected = b;
     if(b) {
-      if((std::string)info.map["type"] == "INPUT" ||
-         (std::string)info.map["type"] == "OUTPUT") {
+      if(desc.kind == NODE_KIND_INPUT ||
+         desc.kind == NODE_KIND_OUTPUT) {
         (*bColors.get())[0] = osg::Vec4(0.62, 1.0, 0.67, 1.0);
         (*bColors.get())[1] = osg::Vec4(0.0, 0.7, 0.0, 1.0);
       }
@@ -1366,17 +1478,17 @@ namespace osg_graph_viz {
       }
     }
     else {
-      if((std::string)info.map["type"] == "INPUT") {
+      if(desc.kind == NODE_KIND_INPUT) {
         (*bColors.get())[0] = osg::Vec4(0.82, 1.0, 0.87, 1.0);
         (*bColors.get())[1] = osg::Vec4(0.0, 0.0, 0.0, 1.0);
       }
-      else if((std::string)info.map["type"] == "OUTPUT") {
+      else if(desc.kind == NODE_KIND_OUTPUT) {
         (*bColors.get())[0] = osg::Vec4(0.52, 0.67, 1.0, 1.0);
         (*bColors.get())[1] = osg::Vec4(0.0, 0.0, 0.0, 1.0);
-      }else if((std::string)info.map["type"] == "DES") {
+      }else if(desc.kind == NODE_KIND_DES) {
         (*bColors.get())[1] = osg::Vec4(1.0, 1.0, 0.9, 1.0);
         (*bColors.get())[2] = osg::Vec4(0.0, 0.0, 0.0, 1.0);
-      }else if((std::string)info.map["type"] == "META") {
+      }else if(desc.kind == NODE_KIND_META) {
         (*bColors.get())[1] = osg::Vec4(1.0, 0.5, 0.5, 1.0);
         (*bColors.get())[2] = osg::Vec4(0.0, 0.0, 0.0, 1.0);
       }
@@ -1385,15 +1497,16 @@ namespace osg_graph_viz {
         (*bColors.get())[2] = osg::Vec4(0.0, 0.0, 0.0, 1.0);
       }
     }
-    bGeom->dirtyDisplayList();
-    bGeom->dirtyBound();
-    vertices->dirty();
+    bColors->dirty();
+    view->updateFlatNode(this);
   }
 
   osg::Geode* Node::createRect(double w, double h, double x, double y,
                                std::string textureFile) {
     osg::Geode *geode = new osg::Geode;
     osg::Geometry *geom = new osg::Geometry;
+    geom->setUseDisplayList(false);
+    geom->setUseVertexBufferObjects(true);
 
     osg::Vec3Array *vertices = new osg::Vec3Array();
     vertices->push_back(osg::Vec3(x, y, 0.0));
@@ -1439,6 +1552,8 @@ namespace osg_graph_viz {
                                 osg::Vec4 color, osg::Vec4 bcolor) {
     osg::Geode *geode = new osg::Geode;
     osg::Geometry *geom = new osg::Geometry;
+    geom->setUseDisplayList(false);
+    geom->setUseVertexBufferObjects(true);
 
     osg::Vec3Array *vertices = new osg::Vec3Array();
     vertices->push_back(osg::Vec3(x, y, -0.01));
@@ -1475,6 +1590,22 @@ namespace osg_graph_viz {
     }
   }
 
+  void Node::getWorldRectangle(double *x1, double *x2, double *y1, double *y2) {
+    getRectangle(x1, x2, y1, y2);
+    convertPosToWorld(x1, y1);
+    convertPosToWorld(x2, y2);
+  }
+
+  void Node::updateBounds() {
+    view->updateNodeBounds(this);
+    for(size_t i=0; i<children->getNumChildren(); ++i) {
+      osg_graph_viz::Node *node = dynamic_cast<osg_graph_viz::Node*>(children->getChild(i));
+      if(node) {
+        node->updateBounds();
+      }
+    }
+  }
+
   void Node::updateSize() {
     resizeHeight();
     resizeWidth();
@@ -1493,14 +1624,14 @@ namespace osg_graph_viz {
         if(-y1 > h) h = -y1;
       }
     }
-    if((std::string)info.map["type"] == "INPUT" ||
-       (std::string)info.map["type"] == "OUTPUT") {
+    if(desc.kind == NODE_KIND_INPUT ||
+       desc.kind == NODE_KIND_OUTPUT) {
       h2 = std::max(portSpaceY - 2.0, headerFontSize + 2.0);
     }
-    else if((std::string)info.map["type"] == "DES") {
+    else if(desc.kind == NODE_KIND_DES) {
       h2 = headerHeight + portSpaceY*(maxPorts);
     }
-    else if((std::string)info.map["type"] == "META") {
+    else if(desc.kind == NODE_KIND_META) {
       h2 = headerHeight + portSpaceY*(maxPorts);
     }
     else {
@@ -1509,9 +1640,9 @@ namespace osg_graph_viz {
     if(h2 > h) h = h2;
     height = h;
     resizeHeight(h);
-    bGeom->dirtyDisplayList();
-    bGeom->dirtyBound();
     vertices->dirty();
+    bGeom->dirtyBound();
+    updateBounds();
   }
 
   void Node::resizeHeight(double v) {
@@ -1520,12 +1651,12 @@ namespace osg_graph_viz {
   }
 
   void Node::resizeWidth() {
-    if((std::string)info.map["type"] == "INPUT" ||
-       (std::string)info.map["type"] == "OUTPUT") {
+    if(desc.kind == NODE_KIND_INPUT ||
+       desc.kind == NODE_KIND_OUTPUT) {
       double x1, x2, y1, y2;
       nodeName->getRectangle(&x1, &x2, &y1, &y2);
       width = x2-x1+16;
-      if((std::string)info.map["type"] == "INPUT") {
+      if(desc.kind == NODE_KIND_INPUT) {
         outPorts[0]->labels[0]->getRectangle(&x1, &x2, &y1, &y2);
         width += x2-x1+10;
       }
@@ -1534,10 +1665,10 @@ namespace osg_graph_viz {
         width += x2-x1+10;
         nodeName->setPosition(x2+10, y1);
       }
-    }else if((std::string)info.map["type"] == "DES") {
+    }else if(desc.kind == NODE_KIND_DES) {
       // the description nodes are handled differently
       return;
-    }else if((std::string)info.map["type"] == "META") {
+    }else if(desc.kind == NODE_KIND_META) {
       // the meta nodes are handled differently
       return;
     }else {
@@ -1594,9 +1725,9 @@ namespace osg_graph_viz {
     }
     resizeWidth(width);
     updateEdges();
-    bGeom->dirtyDisplayList();
-    bGeom->dirtyBound();
     vertices->dirty();
+    bGeom->dirtyBound();
+    updateBounds();
   }
 
   void Node::resizeWidth(double v) {
@@ -1606,8 +1737,8 @@ namespace osg_graph_viz {
     vertices->at(7).x() = v;
     vertices->at(10).x() = v;
     vertices->at(11).x() = v;
-    if((std::string)info.map["type"] != "INPUT" &&
-       (std::string)info.map["type"] != "OUTPUT") {
+    if(desc.kind != NODE_KIND_INPUT &&
+       desc.kind != NODE_KIND_OUTPUT) {
       double left, right, top, bottom;
       nodeName->getRectangle(&left, &right, &top, &bottom);
       nodeName->setPosition(width*0.5, top);
@@ -1636,6 +1767,8 @@ namespace osg_graph_viz {
                                std::string color, bool gardientHeader) {
     osg::Geode *geode = new osg::Geode;
     bGeom = new osg::Geometry;
+    bGeom->setUseDisplayList(false);
+    bGeom->setUseVertexBufferObjects(true);
 
     vertices = new osg::Vec3Array();
 
@@ -1745,11 +1878,11 @@ namespace osg_graph_viz {
   }
 
   std::vector<std::pair<int, std::string> > Node::getOutFoldInfo(int index) {
-    if((std::string)info.map["type"] == "INPUT") {
+    if(desc.kind == NODE_KIND_INPUT) {
       std::vector<std::pair<int, std::string> > r;
       std::pair<int, std::string> p;
       p.first = 0;
-      p.second = (std::string)info.map["name"];
+      p.second = desc.name;
       r.push_back(p);
       return r;
     }
@@ -1757,11 +1890,11 @@ namespace osg_graph_viz {
   }
 
   std::vector<std::pair<int, std::string> > Node::getInFoldInfo(int index) {
-    if((std::string)info.map["type"] == "OUTPUT") {
+    if(desc.kind == NODE_KIND_OUTPUT) {
       std::vector<std::pair<int, std::string> > r;
       std::pair<int, std::string> p;
       p.first = 0;
-      p.second = (std::string)info.map["name"];
+      p.second = desc.name;
       r.push_back(p);
       return r;
     }
@@ -1773,15 +1906,15 @@ namespace osg_graph_viz {
     std::vector<std::pair<int, std::string> > r;
     std::pair<int, std::string> p;
     p.first = index;
-    p.second = (std::string)info.map[tag][index]["name"];
+    const std::vector<PortDescriptor> &ports = tag == "inputs" ? desc.inputs : desc.outputs;
+    p.second = ports[index].name;
     r.push_back(p);
-    int state = info.map[tag][index]["fold"]["state"];
-    if(state == 1) {
+    if(ports[index].hasFold && ports[index].foldState == 1) {
       int i = 1;
-      int num = info.map[tag][index]["fold"]["num"];
+      int num = ports[index].foldNum;
       while(i<num) {
         p.first = index+i;
-        p.second = (std::string)info.map[tag][index+i]["name"];
+        p.second = ports[index+i].name;
         r.push_back(p);
         ++i;
       }
@@ -1790,25 +1923,39 @@ namespace osg_graph_viz {
   }
 
   std::string Node::getInPortName(int index) {
-    if((std::string)info.map["type"] == "INPUT") {
-      return (std::string)info.map["name"];
+    if(desc.kind == NODE_KIND_INPUT) {
+      return desc.name;
     }
     else {
-      return (std::string)info.map["inputs"][index]["name"];
+      return desc.inputs[index].name;
     }
   }
 
   std::string Node::getOutPortName(int index) {
-    if((std::string)info.map["type"] == "OUTPUT") {
-      return (std::string)info.map["name"];
+    if(desc.kind == NODE_KIND_OUTPUT) {
+      return desc.name;
     }
     else {
-      return (std::string)info.map["outputs"][index]["name"];
+      return desc.outputs[index].name;
+    }
+  }
+
+  int Node::getInPortIndex(const std::string &name) {
+    for(size_t i=0; i<inPorts.size(); ++i) {
+      if(getInPortName(i) == name) return i;
+    }
+    return -1;
+  }
+
+  int Node::getOutPortIndex(const std::string &name) {
+    for(size_t i=0; i<outPorts.size(); ++i) {
+      if(getOutPortName(i) == name) return i;
     }
+    return -1;
   }
 
   std::string Node::getName() {
-    return (std::string)info.map["name"];
+    return desc.name;
   }
   std::string Node::getAlias()
   {
@@ -1818,21 +1965,21 @@ namespace osg_graph_viz {
   }
 
   bool Node::isInput() {
-    return (std::string)info.map["type"] == "INPUT";
+    return desc.kind == NODE_KIND_INPUT;
   }
 
   bool Node::isOutput() {
-    return (std::string)info.map["type"] == "OUTPUT";
+    return desc.kind == NODE_KIND_OUTPUT;
   }
 
   void Node::reposition() {
-    if((std::string)info.map["type"] == "INPUT") {
+    if(desc.kind == NODE_KIND_INPUT) {
       if(outPorts[0]->edges.size() > 0) {
         osg::Vec3 v = outPorts[0]->edges.front()->getEndPosition();
         setPosition(v.x()-50-width, v.y()+height*0.5);
       }
     }
-    else if((std::string)info.map["type"] == "OUTPUT") {
+    else if(desc.kind == NODE_KIND_OUTPUT) {
       if(inPorts[0]->edges.size() > 0) {
         osg::Vec3 v = inPorts[0]->edges.front()->getStartPosition();
         setPosition(v.x()+50, v.y()+height*0.5);
@@ -1841,54 +1988,48 @@ namespace osg_graph_viz {
   }
 
   NodeInfo Node::getNodeInfo(){
+    writeMap();
     return info;
   }
 
   void Node::setNodeInfo(NodeInfo new_info){
+    std::string oldName = getName();
     info = new_info;
+    parseDescriptor();
+    view->updateNodeName(oldName, this);
   }
 
   void Node::derenderText(const bool readable){
-    if(readable){//adds text to the Graph, here the texts are the names a Node has.
-      pos->removeChild((osg::Node*)nodeName->getOSGNode());
-      pos->addChild((osg::Node*)nodeName->getOSGNode());
-      //derenderTextInPort(readable);
-      for(size_t i=0; i<inPorts.size(); ++i) { // it is necessary to add the "names" of the ports (in- and outPorts).
-        if(inPorts[i]->hidden) continue;
-        for(size_t n=0; n<inPorts[i]->labels.size(); ++n) {
-          pos->removeChild((osg::Node*) inPorts[i]->labels[n]->getOSGNode());
-          pos->addChild((osg::Node*) inPorts[i]->labels[n]->getOSGNode());
-        }
-      }
-
-      for(size_t i=0; i<outPorts.size(); ++i) {//same for outPorts
-        if(outPorts[i]->hidden) continue;
-        for(size_t n=0; n<outPorts[i]->labels.size(); ++n) {
-          pos->removeChild((osg::Node*) outPorts[i]->labels[n]->getOSGNode());
-          pos->addChild((osg::Node*) outPorts[i]->labels[n]->getOSGNode());
-        }
-      }
+    // the labels stay attached, only their node masks are switched
+    unsigned int mask = readable ? ~0u : 0u;
+    textVisible = readable;
+    if(textBatch.valid()) {
+      // the own drawables of batched labels stay masked
+      textBatch->setNodeMask(mask);
+      return;
     }
-    else{//removes text from the Graph
-      pos->removeChild((osg::Node*)nodeName->getOSGNode());
-      //derenderTextInPort(readable);
-      for(size_t i=0; i<inPorts.size(); ++i) {// // it is necessary to remove the "names" of the ports (in- and outPorts).
-        if(inPorts[i]->hidden) continue;
-        for(size_t n=0; n<inPorts[i]->labels.size(); ++n) {
-          pos->removeChild((osg::Node*) inPorts[i]->labels[n]->getOSGNode());
-        }
+    if(nodeName.valid()) {
+      ((osg::Node*)nodeName->getOSGNode())->setNodeMask(mask);
+    }
+    for(size_t i=0; i<inPorts.size(); ++i) {
+      for(size_t n=0; n<inPorts[i]->labels.size(); ++n) {
+        ((osg::Node*)inPorts[i]->labels[n]->getOSGNode())->setNodeMask(mask);
       }
-
-      for(size_t i=0; i<outPorts.size(); ++i) {//same for outPorts
-        if(outPorts[i]->hidden) continue;
-        for(size_t n=0; n<outPorts[i]->labels.size(); ++n) {
-          pos->removeChild((osg::Node*) outPorts[i]->labels[n]->getOSGNode());
-        }
+    }
+    for(size_t i=0; i<outPorts.size(); ++i) {
+      for(size_t n=0; n<outPorts[i]->labels.size(); ++n) {
+        ((osg::Node*)outPorts[i]->labels[n]->getOSGNode())->setNodeMask(mask);
       }
     }
   }
 
 
+  void Node::syncText() {
+    if(textBatch.valid()) {
+      textBatch->sync(pos.get());
+    }
+  }
+
   void Node::dirty(void) {
     // linesGeom->dirtyDisplayList();
     // linesGeom->dirtyBound();
@@ -1898,6 +2039,16 @@ namespace osg_graph_viz {
     return ConfigMap();
   }
 
+  bool Node::isCompatible(Node *source, int sourceIdx, size_t index) {
+    ConfigMap info = source->getOutPortEdgeInfo(sourceIdx);
+    return isCompatible(info, index);
+  }
+
+  void Node::markCompatibleInputs(Node *source, int sourceIdx) {
+    ConfigMap info = source->getOutPortEdgeInfo(sourceIdx);
+    markInputsByEdgeInfo(info);
+  }
+
   std::vector<osg::ref_ptr<osg_graph_viz::Edge> > Node::getOutputEdges() {
     std::vector<osg::ref_ptr<osg_graph_viz::Edge> > outEdges;
     for(size_t i=0; i<outPorts.size(); ++i) {
@@ -1922,7 +2073,7 @@ namespace osg_graph_viz {
       for(auto label: it->labels) {
         View::exportLabelToSvg(label, f, ol, ot);
       }
-      std::string merge = info.map["inputs"][i]["type"];
+      std::string merge = desc.inputs[i].type;
       std::string rotate = " ";
       double x2 = ol;
       double y2 = ot-portPosY+portFontSize*0.41;
@@ -10,11 +10,13 @@
 #include <osg/MatrixTransform>
 #include <osg/Geometry>
 #include <osg/PositionAttitudeTransform>
+#include <unordered_map>
 
 #include <mars/osg_text/Text.h>
 #include <configmaps/ConfigMap.hpp>
 
 #include "Edge.hpp"
+#include "TextBatch.hpp"
 
 namespace osg_material_manager {
   class OsgMaterialManager;
@@ -43,6 +45,47 @@ namespace osg_graph_viz {
     configmaps::ConfigMap map;
   };
 
+  enum NodeKind {
+    NODE_KIND_DEFAULT,
+    NODE_KIND_INPUT,
+    NODE_KIND_OUTPUT,
+    NODE_KIND_DES,
+    NODE_KIND_META
+  };
+
+  enum NodeDomain {
+    NODE_DOMAIN_NONE,
+    NODE_DOMAIN_SOFTWARE,
+    NODE_DOMAIN_ASSEMBLY,
+    NODE_DOMAIN_ELECTRONICS,
+    NODE_DOMAIN_MECHANICS,
+    NODE_DOMAIN_BEHAVIOR,
+    NODE_DOMAIN_COMPUTATION,
+    NODE_DOMAIN_OTHER
+  };
+
+  // typed copy of one entry of the "inputs" or "outputs" of the NodeInfo map
+  struct PortDescriptor {
+    std::string name, type, alias, direction;
+    // lower case, empty if the port has no own domain
+    std::string domain;
+    double bias, def;
+    int interface;
+    bool hasFold;
+    int foldState, foldNum;
+  };
+
+  // parsed once from the NodeInfo map, the map itself is only rebuilt in
+  // Node::getMap()
+  struct NodeDescriptor {
+    NodeKind kind;
+    NodeDomain domain;
+    // lower case value of the "domain" entry
+    std::string domainName;
+    std::string name, type;
+    std::vector<PortDescriptor> inputs, outputs;
+  };
+
   struct Port {
     std::vector<osg::ref_ptr<osg_text::Text> > labels;
     osg::ref_ptr<osg::Geode> geode, foldIcon;
@@ -82,11 +125,17 @@ namespace osg_graph_viz {
     virtual double getWidth() {return width;}
     virtual double getHeight() {return height;}
     virtual void getRectangle(double *x1, double *x2, double *y1, double *y2);
+    void getWorldRectangle(double *x1, double *x2, double *y1, double *y2);
+    // updates the picking bounds of the node and its children in the view
+    virtual void updateBounds();
     virtual osg::Vec3 getInPortPos(int index);
     virtual bool hasInPortConnection(int index);
     virtual osg::Vec3 getOutPortPos(int index);
     virtual void addInputEdge(int index, Edge* edge);
     virtual void addOutputEdge(int index, Edge* edge);
+    // while deferred the added edges only mark the node, the ports are
+    // laid out once when the deferral ends
+    void setLayoutDeferred(bool v);
     virtual void setRenderOrder(int o);
     virtual void setLineWidth(double w);
     virtual bool checkMouseInPortHover(double x, double y, double *vX, double *vY, Port *p);
@@ -100,15 +149,19 @@ namespace osg_graph_viz {
     virtual void removeEdges();
     virtual void decoupleEdges();
     virtual void updateMap(const configmaps::ConfigMap &map);
-    virtual const configmaps::ConfigMap& getMap() {return info.map;}
+    virtual const configmaps::ConfigMap& getMap();
     virtual void setSelected(bool s);
     virtual bool isSelected() {return selected;}
+    bool isHidden() const {return hidden;}
     virtual std::vector<std::pair<int, std::string> > getOutFoldInfo(int index);
     virtual std::vector<std::pair<int, std::string> > getInFoldInfo(int index);
     virtual std::vector<std::pair<int, std::string> > getFoldInfo(std::string tag,
                                                                   int index);
     virtual std::string getInPortName(int index);
     virtual std::string getOutPortName(int index);
+    // returns -1 if the node has no port with the given name
+    int getInPortIndex(const std::string &name);
+    int getOutPortIndex(const std::string &name);
     virtual std::string getName();
     virtual std::string getAlias();
     virtual bool isInput();
@@ -121,9 +174,14 @@ namespace osg_graph_viz {
     virtual void markInputsByEdgeInfo(configmaps::ConfigMap &map) {}
     virtual void unmarkInputs() {}
     virtual bool isCompatible(configmaps::ConfigMap &map, size_t index) {return true;}
+    // same as above for an edge starting at the given output port
+    virtual bool isCompatible(Node *source, int sourceIdx, size_t index);
+    virtual void markCompatibleInputs(Node *source, int sourceIdx);
     /*void confMapToYml(Node *node);
     void SelRecResize(double w, double h,Node *node);*/
     virtual void updateEdges();
+    // collects the port positions of the edges of the node and its children
+    void getEdgeEndPoints(std::unordered_map<Edge*, EdgeEndPoints> *points);
     virtual void addChildNode(osg::ref_ptr<osg_graph_viz::Node> node);
     virtual void removeChildNode(osg::ref_ptr<osg_graph_viz::Node> node);
     virtual void setParentNode(osg::ref_ptr<osg_graph_viz::Node> node)
@@ -137,6 +195,7 @@ namespace osg_graph_viz {
     virtual void applyFontScale(double s);
     virtual void filterUpdate() {}
     std::vector<osg::ref_ptr<osg_graph_viz::Edge> > getOutputEdges();
+    const NodeDescriptor& getDescriptor() const {return desc;}
     virtual void exportSvg(FILE *f, double ol, double ot) {}
     virtual void exportPortsSVG(FILE *f, double ol, double ot);
     std::string replaceString(const std::string &source, const std::string &s1,
@@ -145,11 +204,13 @@ namespace osg_graph_viz {
   protected:
     osg_material_manager::OsgMaterialManager *materialManager;
     NodeInfo info;
+    NodeDescriptor desc;
     View *view;
     double posX, posY, width, height, headerHeight, portStartY;
     double posOffsetX, posOffsetY;
     int maxPorts;
     bool ignoreNextInPort, ignoreNextOutPort, selected, hidden;
+    bool layoutDeferred, layoutDirty;
     double portFontSize, headerFontSize;
     double portSpaceY;
     double mergeIconSize, foldIconSize;
@@ -158,6 +219,8 @@ namespace osg_graph_viz {
     std::vector<double> portOffsets;
     osg::ref_ptr<osg::PositionAttitudeTransform> pos, pos2;
     osg::ref_ptr<osg_text::Text> nodeName, textBody;
+    // draws the labels if the view uses batched text
+    osg::ref_ptr<TextBatch> textBatch;
     osg::ref_ptr<osg::LineWidth> linew;
     std::map<std::string, std::string> mergeImages;
     osg::ref_ptr<osg::Vec4Array> bColors;
@@ -168,6 +231,12 @@ namespace osg_graph_viz {
     std::vector<Port*> inPorts, outPorts;
     osg::ref_ptr<osg::MatrixTransform> children;
     double portScale;
+    unsigned long pickOrder;
+    // position in the node list of the view
+    std::list<osg::ref_ptr<osg_graph_viz::Node> >::iterator listHandle;
+    bool inNodeList;
+    // false while the view is zoomed out, the labels are masked then
+    bool textVisible;
 
     osg::Geode* createRect(double w, double h, double x, double y,
                            std::string textureFile);
@@ -182,9 +251,19 @@ namespace osg_graph_viz {
     void handleMeta();
     virtual void resizeWidth();
     virtual void resizeHeight();
+    // lays out the ports after their edges have changed
+    virtual void relayout();
     virtual void resizeWidth(double v);
     virtual void resizeHeight(double v);
     void updateParentFromMap(configmaps::ConfigMap &map);
+    // reads the kind, domain and ports of info.map into desc
+    void parseDescriptor();
+    // writes the position and fold states back into info.map
+    void writeMap();
+    void writeFolds(const std::string &tag,
+                    const std::vector<PortDescriptor> &ports);
+    // rewrites the batched glyphs of the labels that have changed
+    void syncText();
     //void resizeWidth(double w);
     //void resizeHeight(double h);
     //void derenderTextInPort(const bool readable);
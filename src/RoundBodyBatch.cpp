@@ -0,0 +1,156 @@
+/**
+ * \file RoundBodyBatch.cpp
+ * \brief Draws the bodies of all round nodes with one instanced draw call.
+ */
+
+#include "RoundBodyBatch.hpp"
+
+#include <osg/Program>
+#include <osg/Shader>
+#include <osg/VertexAttribDivisor>
+
+namespace osg_graph_viz {
+
+  // generic attributes that are not aliased by the fixed function arrays
+  // used in the shaders
+  enum {
+    RECT_ATTRIB = 9,
+    FRAME_ATTRIB = 10,
+    BODY_COLOR_ATTRIB = 11,
+    FRAME_COLOR_ATTRIB = 12
+  };
+
+  RoundBodyBatch::RoundBodyBatch(const std::string &shaderPath) : enabled(true) {
+    geom = new osg::Geometry;
+    geom->setDataVariance(osg::Object::DYNAMIC);
+    geom->setUseDisplayList(false);
+    geom->setUseVertexBufferObjects(true);
+    // the unit quad is placed by the vertex shader
+    geom->setCullingActive(false);
+    setCullingActive(false);
+
+    osg::Vec3Array *vertices = new osg::Vec3Array();
+    vertices->push_back(osg::Vec3(0, 0, 0));
+    vertices->push_back(osg::Vec3(1, 0, 0));
+    vertices->push_back(osg::Vec3(0, 1, 0));
+    vertices->push_back(osg::Vec3(1, 1, 0));
+    geom->setVertexArray(vertices);
+    drawArrays = new osg::DrawArrays(osg::PrimitiveSet::TRIANGLE_STRIP, 0, 4);
+    geom->addPrimitiveSet(drawArrays.get());
+
+    rects = new osg::Vec4Array();
+    frames = new osg::Vec4Array();
+    bodyColors = new osg::Vec4Array();
+    frameColors = new osg::Vec4Array();
+    geom->setVertexAttribArray(RECT_ATTRIB, rects.get(),
+                               osg::Array::BIND_PER_VERTEX);
+    geom->setVertexAttribArray(FRAME_ATTRIB, frames.get(),
+                               osg::Array::BIND_PER_VERTEX);
+    geom->setVertexAttribArray(BODY_COLOR_ATTRIB, bodyColors.get(),
+                               osg::Array::BIND_PER_VERTEX);
+    geom->setVertexAttribArray(FRAME_COLOR_ATTRIB, frameColors.get(),
+                               osg::Array::BIND_PER_VERTEX);
+    addDrawable(geom.get());
+
+    osg::Program *program = new osg::Program();
+    program->addShader(osg::Shader::readShaderFile(osg::Shader::VERTEX,
+                                                   shaderPath + "round_rect_instanced.vert"));
+    program->addShader(osg::Shader::readShaderFile(osg::Shader::FRAGMENT,
+                                                   shaderPath + "round_rect_instanced.frag"));
+    program->addBindAttribLocation("instanceRect", RECT_ATTRIB);
+    program->addBindAttribLocation("instanceFrame", FRAME_ATTRIB);
+    program->addBindAttribLocation("instanceBodyColor", BODY_COLOR_ATTRIB);
+    program->addBindAttribLocation("instanceFrameColor", FRAME_COLOR_ATTRIB);
+
+    osg::StateSet *state = getOrCreateStateSet();
+    state->setAttributeAndModes(program, osg::StateAttribute::ON);
+    state->setAttributeAndModes(new osg::VertexAttribDivisor(RECT_ATTRIB, 1));
+    state->setAttributeAndModes(new osg::VertexAttribDivisor(FRAME_ATTRIB, 1));
+    state->setAttributeAndModes(new osg::VertexAttribDivisor(BODY_COLOR_ATTRIB, 1));
+    state->setAttributeAndModes(new osg::VertexAttribDivisor(FRAME_COLOR_ATTRIB, 1));
+    state->setMode(GL_BLEND, osg::StateAttribute::ON);
+    // below the nodes and edges, their bins start at 30
+    state->setRenderBinDetails(20, "RenderBin");
+    // an instance count of zero would draw a single non instanced quad
+    setNodeMask(0);
+  }
+
+  void RoundBodyBatch::add(Node *node) {
+    std::lock_guard<std::mutex> lock(mutex);
+    if(slots.find(node) != slots.end()) return;
+    slots[node] = nodes.size();
+    nodes.push_back(node);
+    rects->push_back(osg::Vec4(0, 0, 0, 0));
+    frames->push_back(osg::Vec4(0, 0, 1, 0));
+    bodyColors->push_back(osg::Vec4(0, 0, 0, 0));
+    frameColors->push_back(osg::Vec4(0, 0, 0, 0));
+    dirtyArrays();
+  }
+
+  void RoundBodyBatch::remove(Node *node) {
+    std::lock_guard<std::mutex> lock(mutex);
+    std::unordered_map<Node*, size_t>::iterator it = slots.find(node);
+    if(it == slots.end()) return;
+    size_t slot = it->second;
+    size_t last = nodes.size()-1;
+    if(slot != last) {
+      nodes[slot] = nodes[last];
+      slots[nodes[slot]] = slot;
+      (*rects)[slot] = (*rects)[last];
+      (*frames)[slot] = (*frames)[last];
+      (*bodyColors)[slot] = (*bodyColors)[last];
+      (*frameColors)[slot] = (*frameColors)[last];
+    }
+    slots.erase(node);
+    nodes.pop_back();
+    rects->pop_back();
+    frames->pop_back();
+    bodyColors->pop_back();
+    frameColors->pop_back();
+    dirtyArrays();
+  }
+
+  bool RoundBodyBatch::contains(Node *node) const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return slots.find(node) != slots.end();
+  }
+
+  void RoundBodyBatch::update(Node *node, const osg::Vec4 &rect,
+                              const osg::Vec4 &frame,
+                              const osg::Vec4 &bodyColor,
+                              const osg::Vec4 &frameColor) {
+    std::lock_guard<std::mutex> lock(mutex);
+    std::unordered_map<Node*, size_t>::iterator it = slots.find(node);
+    if(it == slots.end()) return;
+    size_t slot = it->second;
+    // osg uploads a dirty array as a whole, so only the arrays with a
+    // changed value are marked
+    setValue(rects.get(), slot, rect);
+    setValue(frames.get(), slot, frame);
+    setValue(bodyColors.get(), slot, bodyColor);
+    setValue(frameColors.get(), slot, frameColor);
+  }
+
+  void RoundBodyBatch::setValue(osg::Vec4Array *array, size_t slot,
+                                const osg::Vec4 &value) {
+    if((*array)[slot] == value) return;
+    (*array)[slot] = value;
+    array->dirty();
+  }
+
+  void RoundBodyBatch::setEnabled(bool v) {
+    enabled = v;
+    setNodeMask(nodes.empty() || !enabled ? 0 : ~0);
+  }
+
+  void RoundBodyBatch::dirtyArrays() {
+    drawArrays->setNumInstances(nodes.size());
+    drawArrays->dirty();
+    rects->dirty();
+    frames->dirty();
+    bodyColors->dirty();
+    frameColors->dirty();
+    setNodeMask(nodes.empty() || !enabled ? 0 : ~0);
+  }
+
+} // end of namespace: osg_graph_viz
@@ -0,0 +1,60 @@
+/**
+ * \file RoundBodyBatch.hpp
+ * \brief Draws the bodies of all round nodes with one instanced draw call.
+ **/
+
+#ifndef OSG_GRAPH_VIZ_ROUND_BODY_BATCH_HPP
+#define OSG_GRAPH_VIZ_ROUND_BODY_BATCH_HPP
+
+#include <osg/Geode>
+#include <osg/Geometry>
+
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <mutex>
+
+namespace osg_graph_viz {
+
+  class Node;
+
+  /**
+   * Every registered node owns one instance slot. The per instance
+   * attributes hold the world rectangle (x, y, width, height), the frame
+   * (width, radius, scale, visible) and the body and frame colors. Nodes
+   * that are hidden themselves or by an ancestor are not visible. Removing
+   * a node moves the last slot into the freed one, so the arrays stay
+   * dense and the instance count equals the number of nodes. The nodes
+   * built by the load threads of the view register concurrently.
+   */
+  class RoundBodyBatch : public osg::Geode {
+
+  public:
+    explicit RoundBodyBatch(const std::string &shaderPath);
+
+    void add(Node *node);
+    void remove(Node *node);
+    bool contains(Node *node) const;
+    // ignores nodes that are not registered
+    void update(Node *node, const osg::Vec4 &rect, const osg::Vec4 &frame,
+                const osg::Vec4 &bodyColor, const osg::Vec4 &frameColor);
+    size_t size() const {return nodes.size();}
+    // masks the whole batch independent of the number of instances
+    void setEnabled(bool v);
+
+  private:
+    osg::ref_ptr<osg::Geometry> geom;
+    osg::ref_ptr<osg::DrawArrays> drawArrays;
+    osg::ref_ptr<osg::Vec4Array> rects, frames, bodyColors, frameColors;
+    std::vector<Node*> nodes;
+    std::unordered_map<Node*, size_t> slots;
+    bool enabled;
+    mutable std::mutex mutex;
+
+    void dirtyArrays();
+    void setValue(osg::Vec4Array *array, size_t slot, const osg::Vec4 &value);
+  };
+
+} // end of namespace: osg_graph_viz
+
+#endif // OSG_GRAPH_VIZ_ROUND_BODY_BATCH_HPP
@@ -22,7 +22,6 @@
 // x is going from left to right
 
 #include <mars/osg_material_manager/OsgMaterialManager.h>
-#include <mars/osg_material_manager/MaterialNode.h>
 
 using namespace configmaps;
 using namespace osg_material_manager;
@@ -36,8 +35,9 @@ namespace osg_graph_viz {
   RoundBodyNode::RoundBodyNode(const NodeInfo &info_, View *v) : Node(v) {
     sizeOffset = 12;
     info = info_;
-    if((std::string)info.map["type"] == "INPUT" ||
-       (std::string)info.map["type"] == "OUTPUT") {
+    parseDescriptor();
+    if(desc.kind == NODE_KIND_INPUT ||
+       desc.kind == NODE_KIND_OUTPUT) {
       sizeOffset = 4;
     }
     initContent();
@@ -45,36 +45,68 @@ namespace osg_graph_viz {
   }
 
   RoundBodyNode::~RoundBodyNode(void) {
+    if(bodyBatch.valid()) {
+      bodyBatch->remove(this);
+    }
   }
 
   void RoundBodyNode::initRoundBody() {
-    std::string loadPath = view->getResourcesPath() + "/shader/";
-    ConfigMap mMap = ConfigMap::fromYamlFile(loadPath + "round_rect.yml");
-    mMap["loadPath"] = loadPath;
-    materialManager->createMaterial("round_rect", mMap);
-    materialGroup = materialManager->getNewMaterialGroup("round_rect");
-    osg_material_manager::MaterialNode *materialNode = dynamic_cast<osg_material_manager::MaterialNode*>(materialGroup.get());
-    //materialGroup->addChild(pos2.get());
-    framePos->setStateSet(materialNode->getMaterial()->getOrCreateStateSet());
+    // the material is shared by all nodes, only the uniforms are per node
+    framePos->setStateSet(view->loadMaterial("round_rect"));
     bGeode->getOrCreateStateSet()->addUniform(sizeUniform.get());
     bGeode->getOrCreateStateSet()->addUniform(frameUniform.get());
     bGeode->getOrCreateStateSet()->addUniform(bodyColorUniform.get());
     bGeode->getOrCreateStateSet()->addUniform(frameColorUniform.get());
     pos->removeChild(bGeode.get());
     framePos->addChild(bGeode.get());
-    pos->insertChild(0, framePos.get());
+    bodyBatch = view->getRoundBodyBatch();
+    if(bodyBatch.valid()) {
+      bodyBatch->add(this);
+      updateBodyInstance();
+    }
+    else {
+      pos->insertChild(0, framePos.get());
+    }
+  }
+
+  void RoundBodyNode::updateBodyInstance() {
+    if(!bodyBatch.valid()) return;
+    double x = posX + frameX;
+    double y = posY + frameY - height - sizeOffset*0.5;
+    convertPosToWorld(&x, &y);
+    double s = parent.valid() ? parent->getChildrenScale() : 1.0;
+    // the children of a hidden node are removed from the view with it
+    bool visible = !hidden;
+    for(osg_graph_viz::Node *p=parent.get(); visible && p; p=p->getParentNode().get()) {
+      visible = !p->isHidden();
+    }
+    osg::Vec3f frame;
+    osg::Vec4f bodyColor, frameColor;
+    frameUniform->get(frame);
+    bodyColorUniform->get(bodyColor);
+    frameColorUniform->get(frameColor);
+    bodyBatch->update(this, osg::Vec4(x, y, width, height+sizeOffset),
+                      osg::Vec4(frame.x(), frame.y(), s, visible ? 1 : 0),
+                      bodyColor, frameColor);
+  }
+
+  void RoundBodyNode::updateBounds() {
+    Node::updateBounds();
+    updateBodyInstance();
   }
 
   osg::Geode* RoundBodyNode::createBody(double w, double h, double x, double y,
                                         std::string color, bool gardientHeader) {
     sizeUniform = new osg::Uniform("size", osg::Vec3f(w, h, 1));
     frameUniform = new osg::Uniform("frame", osg::Vec3f(1, 8, 0));
-    if((std::string)info.map["type"] == "INPUT" ||
-       (std::string)info.map["type"] == "OUTPUT") {
+    if(desc.kind == NODE_KIND_INPUT ||
+       desc.kind == NODE_KIND_OUTPUT) {
       frameUniform->set(osg::Vec3f(1, 6, 0));
     }
     osg::Geode *geode = new osg::Geode;
     bGeom = new osg::Geometry;
+    bGeom->setUseDisplayList(false);
+    bGeom->setUseVertexBufferObjects(true);
     vertices = new osg::Vec3Array();
     framePos = new osg::PositionAttitudeTransform();
     framePos->setPosition(osg::Vec3(x, y-h-sizeOffset*0.5, 0));
@@ -164,8 +196,8 @@ namespace osg_graph_viz {
   void RoundBodyNode::resizeWidth(double v) {
     vertices->at(1).x() = vertices->at(2).x() = v;
     sizeUniform->set(osg::Vec3f(v, height+sizeOffset, 1));
-    if((std::string)info.map["type"] != "INPUT" &&
-       (std::string)info.map["type"] != "OUTPUT") {
+    if(desc.kind != NODE_KIND_INPUT &&
+       desc.kind != NODE_KIND_OUTPUT) {
       double left, right, top, bottom;
       nodeName->getRectangle(&left, &right, &top, &bottom);
       nodeName->setPosition(width*0.5, top);
@@ -173,8 +205,10 @@ namespace osg_graph_viz {
   }
 
   void RoundBodyNode::setRenderOrder(int o) {
+    // the view steps the bins by one per node, the body shares the bin of
+    // its own labels and frame above the previous node
     Node::setRenderOrder(o+1);
-    materialGroup->getOrCreateStateSet()->setRenderBinDetails(o, "RenderBin");
+    bGeode->getOrCreateStateSet()->setRenderBinDetails(o+1, "RenderBin");
   }
 
   void RoundBodyNode::setSelected(bool s) {
@@ -185,11 +219,15 @@ namespace osg_graph_viz {
     else {
       bodyColorUniform->set((*bColors.get())[0]);
     }
+    updateBodyInstance();
+    view->updateFlatNode(this);
   }
 
   void RoundBodyNode::applyColor() {
     bodyColorUniform->set((*bColors.get())[0]);
     frameColorUniform->set((*bColors.get())[1]);
+    updateBodyInstance();
+    view->updateFlatNode(this);
   }
 
   void RoundBodyNode::getRectangle(double *x1, double *x2, double *y1, double *y2) {
@@ -206,8 +244,8 @@ namespace osg_graph_viz {
     y-=ot;
     fprintf(f, "  <g id=\"%s\" transform=\"translate(%g,%g)\">\n", name.c_str(), x, -y-.5*sizeOffset);
     double ry = 8;
-    if ((std::string)info.map["type"] == "INPUT" ||
-        (std::string)info.map["type"] == "OUTPUT")
+    if (desc.kind == NODE_KIND_INPUT ||
+        desc.kind == NODE_KIND_OUTPUT)
     {
       ry = 6;
     }
@@ -8,6 +8,7 @@
 #define OSG_GRAPH_VIZ_ROUND_BODY_NODE_HPP
 
 #include "Node.hpp"
+#include "RoundBodyBatch.hpp"
 #include <osg/Uniform>
 
 namespace osg_graph_viz {
@@ -25,17 +26,20 @@ namespace osg_graph_viz {
     void applyColor();
     void exportSvg(FILE *f, double ol, double ot) override;
     void getRectangle(double *x1, double *x2, double *y1, double *y2) override;
+    void updateBounds() override;
 
   protected:
     osg::ref_ptr<osg::Uniform> sizeUniform, frameUniform, bodyColorUniform, frameColorUniform;
     osg::ref_ptr<osg::PositionAttitudeTransform> framePos;
-    osg::ref_ptr<osg::Group> materialGroup;
+    // set if the body is drawn by the instanced batch of the view
+    osg::ref_ptr<RoundBodyBatch> bodyBatch;
     double frameY, frameX, sizeOffset;
     
     osg::Geode* createBody(double w, double h, double x, double y,
                            std::string textureFile, bool gardientHeader=false) override;
     virtual void resizeHeight(double w) override;
     virtual void resizeWidth(double h) override;
+    void updateBodyInstance();
   };
 
 } // end of namespace: osg_graph_viz
@@ -0,0 +1,204 @@
+/**
+ * \file SegmentBVH.cpp
+ * \brief Bounding volume hierarchy over the pickable parts of the edges.
+ */
+
+#include "SegmentBVH.hpp"
+
+#include <algorithm>
+
+namespace osg_graph_viz {
+
+  SegmentBVH::SegmentBVH() : needsRebuild(false), numBoxes(0), numRefits(0) {
+  }
+
+  void SegmentBVH::update(Edge *edge, const std::vector<PickBox> &boxes) {
+    std::unordered_map<Edge*, Entry>::iterator it = entries.find(edge);
+    if(it == entries.end()) {
+      Entry &e = entries[edge];
+      e.boxes = boxes;
+      numBoxes += boxes.size();
+      needsRebuild = true;
+      return;
+    }
+    Entry &e = it->second;
+    if(needsRebuild || e.boxes.size() != boxes.size()) {
+      numBoxes -= e.boxes.size();
+      numBoxes += boxes.size();
+      e.boxes = boxes;
+      e.leaves.clear();
+      needsRebuild = true;
+      return;
+    }
+    e.boxes = boxes;
+    for(size_t i=0; i<boxes.size(); ++i) {
+      tree[e.leaves[i]].box = boxes[i];
+      refit(tree[e.leaves[i]].parent);
+    }
+    // refitting keeps the topology of the tree, rebuild it once the
+    // boxes were moved around more often than we have boxes
+    if(++numRefits > 2*numBoxes) {
+      needsRebuild = true;
+    }
+  }
+
+  void SegmentBVH::remove(Edge *edge) {
+    std::unordered_map<Edge*, Entry>::iterator it = entries.find(edge);
+    if(it == entries.end()) return;
+    numBoxes -= it->second.boxes.size();
+    entries.erase(it);
+    needsRebuild = true;
+  }
+
+  bool SegmentBVH::contains(Edge *edge) const {
+    return entries.find(edge) != entries.end();
+  }
+
+  void SegmentBVH::clear() {
+    entries.clear();
+    tree.clear();
+    numBoxes = numRefits = 0;
+    needsRebuild = false;
+  }
+
+  void SegmentBVH::queryPoint(double x, double y, std::vector<Edge*> *result) {
+    if(needsRebuild) rebuild();
+    if(tree.empty()) return;
+    size_t first = result->size();
+    std::vector<int> stack;
+    stack.push_back(0);
+    while(!stack.empty()) {
+      const TreeNode &n = tree[stack.back()];
+      stack.pop_back();
+      if(x < n.box.x1 || x > n.box.x2 || y < n.box.y1 || y > n.box.y2) {
+        continue;
+      }
+      if(n.edge) {
+        // several parts of one edge can contain the point
+        if(std::find(result->begin()+first, result->end(), n.edge) == result->end()) {
+          result->push_back(n.edge);
+        }
+        continue;
+      }
+      stack.push_back(n.left);
+      stack.push_back(n.right);
+    }
+  }
+
+  void SegmentBVH::queryRect(double x1, double x2, double y1, double y2,
+                             std::vector<Edge*> *result) {
+    if(needsRebuild) rebuild();
+    if(tree.empty()) return;
+    size_t first = result->size();
+    std::vector<int> stack;
+    stack.push_back(0);
+    while(!stack.empty()) {
+      const TreeNode &n = tree[stack.back()];
+      stack.pop_back();
+      if(n.box.x2 < x1 || n.box.x1 > x2 || n.box.y2 < y1 || n.box.y1 > y2) {
+        continue;
+      }
+      if(n.edge) {
+        result->push_back(n.edge);
+        continue;
+      }
+      stack.push_back(n.left);
+      stack.push_back(n.right);
+    }
+    // large rectangles report many parts of the same edge
+    std::sort(result->begin()+first, result->end());
+    result->erase(std::unique(result->begin()+first, result->end()),
+                  result->end());
+  }
+
+  void SegmentBVH::rebuild() {
+    std::vector<BuildItem> items;
+    items.reserve(numBoxes);
+    std::unordered_map<Edge*, Entry>::iterator it;
+    for(it=entries.begin(); it!=entries.end(); ++it) {
+      it->second.leaves.resize(it->second.boxes.size());
+      for(size_t i=0; i<it->second.boxes.size(); ++i) {
+        const PickBox &b = it->second.boxes[i];
+        BuildItem item;
+        item.edge = it->first;
+        item.part = i;
+        item.cx = (b.x1+b.x2)*0.5;
+        item.cy = (b.y1+b.y2)*0.5;
+        items.push_back(item);
+      }
+    }
+    tree.clear();
+    tree.reserve(2*items.size());
+    if(!items.empty()) {
+      build(items, 0, items.size(), -1);
+    }
+    needsRebuild = false;
+    numRefits = 0;
+  }
+
+  int SegmentBVH::build(std::vector<BuildItem> &items, size_t begin,
+                        size_t end, int parent) {
+    int index = tree.size();
+    tree.push_back(TreeNode());
+    tree[index].parent = parent;
+    tree[index].left = tree[index].right = -1;
+    tree[index].edge = NULL;
+    tree[index].part = -1;
+
+    if(end - begin == 1) {
+      Entry &e = entries[items[begin].edge];
+      tree[index].edge = items[begin].edge;
+      tree[index].part = items[begin].part;
+      tree[index].box = e.boxes[items[begin].part];
+      e.leaves[items[begin].part] = index;
+      return index;
+    }
+
+    // split at the median of the box centers along the longer axis
+    double minX = items[begin].cx, maxX = minX;
+    double minY = items[begin].cy, maxY = minY;
+    for(size_t i=begin+1; i<end; ++i) {
+      minX = std::min(minX, items[i].cx);
+      maxX = std::max(maxX, items[i].cx);
+      minY = std::min(minY, items[i].cy);
+      maxY = std::max(maxY, items[i].cy);
+    }
+    size_t mid = begin + (end-begin)/2;
+    if(maxX-minX > maxY-minY) {
+      std::nth_element(items.begin()+begin, items.begin()+mid, items.begin()+end,
+                       [](const BuildItem &a, const BuildItem &b) {
+                         return a.cx < b.cx;
+                       });
+    }
+    else {
+      std::nth_element(items.begin()+begin, items.begin()+mid, items.begin()+end,
+                       [](const BuildItem &a, const BuildItem &b) {
+                         return a.cy < b.cy;
+                       });
+    }
+    int left = build(items, begin, mid, index);
+    int right = build(items, mid, end, index);
+    tree[index].left = left;
+    tree[index].right = right;
+    tree[index].box = tree[left].box;
+    merge(&tree[index].box, tree[right].box);
+    return index;
+  }
+
+  void SegmentBVH::refit(int nodeIndex) {
+    while(nodeIndex >= 0) {
+      TreeNode &n = tree[nodeIndex];
+      n.box = tree[n.left].box;
+      merge(&n.box, tree[n.right].box);
+      nodeIndex = n.parent;
+    }
+  }
+
+  void SegmentBVH::merge(PickBox *a, const PickBox &b) {
+    if(b.x1 < a->x1) a->x1 = b.x1;
+    if(b.x2 > a->x2) a->x2 = b.x2;
+    if(b.y1 < a->y1) a->y1 = b.y1;
+    if(b.y2 > a->y2) a->y2 = b.y2;
+  }
+
+} // end of namespace: osg_graph_viz
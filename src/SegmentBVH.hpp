@@ -0,0 +1,78 @@
+/**
+ * \file SegmentBVH.hpp
+ * \brief Bounding volume hierarchy over the pickable parts of the edges.
+ **/
+
+#ifndef OSG_GRAPH_VIZ_SEGMENT_BVH_HPP
+#define OSG_GRAPH_VIZ_SEGMENT_BVH_HPP
+
+#include <cstddef>
+#include <vector>
+#include <unordered_map>
+
+namespace osg_graph_viz {
+
+  class Edge;
+
+  struct PickBox {
+    double x1, x2, y1, y2;
+  };
+
+  /**
+   * Each edge registers one box per pickable part (a polyline segment, the
+   * whole smooth curve or the decoupled stubs with their labels). Moving
+   * edge end points only refits the affected leaves and their ancestors.
+   * The tree is rebuilt lazily on the next query if edges were added,
+   * removed, changed their number of parts or the tree degraded by too
+   * many refits.
+   */
+  class SegmentBVH {
+
+  public:
+    SegmentBVH();
+
+    // inserts the edge or refits its boxes if it is already stored
+    void update(Edge *edge, const std::vector<PickBox> &boxes);
+    void remove(Edge *edge);
+    bool contains(Edge *edge) const;
+    void clear();
+    size_t size() const {return entries.size();}
+
+    // appends all edges with at least one box containing the point
+    void queryPoint(double x, double y, std::vector<Edge*> *result);
+    // appends all edges with at least one box intersecting the rectangle
+    void queryRect(double x1, double x2, double y1, double y2,
+                   std::vector<Edge*> *result);
+
+  private:
+    struct TreeNode {
+      PickBox box;
+      int parent, left, right;
+      Edge *edge;     // only set for leaves
+      int part;
+    };
+    struct Entry {
+      std::vector<PickBox> boxes;
+      std::vector<int> leaves;
+    };
+    struct BuildItem {
+      Edge *edge;
+      int part;
+      double cx, cy;
+    };
+
+    std::unordered_map<Edge*, Entry> entries;
+    std::vector<TreeNode> tree;
+    bool needsRebuild;
+    size_t numBoxes, numRefits;
+
+    void rebuild();
+    int build(std::vector<BuildItem> &items, size_t begin, size_t end,
+              int parent);
+    void refit(int nodeIndex);
+    static void merge(PickBox *a, const PickBox &b);
+  };
+
+} // end of namespace: osg_graph_viz
+
+#endif // OSG_GRAPH_VIZ_SEGMENT_BVH_HPP
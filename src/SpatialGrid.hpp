@@ -0,0 +1,189 @@
+/**
+ * \file SpatialGrid.hpp
+ * \brief Uniform grid used by the View to look up scene elements by position.
+ **/
+
+#ifndef OSG_GRAPH_VIZ_SPATIAL_GRID_HPP
+#define OSG_GRAPH_VIZ_SPATIAL_GRID_HPP
+
+#include <vector>
+#include <unordered_map>
+#include <cmath>
+#include <algorithm>
+
+namespace osg_graph_viz {
+
+  /**
+   * Stores axis aligned rectangles (x1 < x2, y1 < y2 in world coordinates)
+   * of arbitrary items in a uniform grid. Point and rectangle queries only
+   * visit the cells touched by the query, so their cost depends on the
+   * local density of the graph and not on its overall size.
+   */
+  template<typename T>
+  class SpatialGrid {
+
+  public:
+    explicit SpatialGrid(double cellSize_=256.0) : cellSize(cellSize_) {}
+
+    // inserts the item or updates its rectangle if it is already stored
+    void insert(T item, double x1, double x2, double y1, double y2) {
+      Entry e;
+      e.x1 = x1;
+      e.x2 = x2;
+      e.y1 = y1;
+      e.y2 = y2;
+      e.cx1 = cellIndex(x1);
+      e.cx2 = cellIndex(x2);
+      e.cy1 = cellIndex(y1);
+      e.cy2 = cellIndex(y2);
+      typename std::unordered_map<T, Entry>::iterator it = entries.find(item);
+      if(it != entries.end()) {
+        if(it->second.cx1 == e.cx1 && it->second.cx2 == e.cx2 &&
+           it->second.cy1 == e.cy1 && it->second.cy2 == e.cy2) {
+          // still covering the same cells, only the rectangle changes
+          it->second = e;
+          return;
+        }
+        removeFromCells(item, it->second);
+        it->second = e;
+      }
+      else {
+        entries[item] = e;
+      }
+      addToCells(item, e);
+    }
+
+    void remove(T item) {
+      typename std::unordered_map<T, Entry>::iterator it = entries.find(item);
+      if(it == entries.end()) return;
+      removeFromCells(item, it->second);
+      entries.erase(it);
+    }
+
+    bool contains(T item) const {
+      return entries.find(item) != entries.end();
+    }
+
+    void clear() {
+      entries.clear();
+      cells.clear();
+    }
+
+    size_t size() const {return entries.size();}
+
+    // appends all items whose rectangle contains the point
+    void queryPoint(double x, double y, std::vector<T> *result) const {
+      typename std::unordered_map<long long, std::vector<T> >::const_iterator it;
+      it = cells.find(cellKey(cellIndex(x), cellIndex(y)));
+      if(it == cells.end()) return;
+      typename std::vector<T>::const_iterator jt = it->second.begin();
+      for(; jt!=it->second.end(); ++jt) {
+        const Entry &e = entries.find(*jt)->second;
+        if(x >= e.x1 && x <= e.x2 && y >= e.y1 && y <= e.y2) {
+          result->push_back(*jt);
+        }
+      }
+    }
+
+    // appends all items whose rectangle intersects the query rectangle
+    void queryRect(double x1, double x2, double y1, double y2,
+                   std::vector<T> *result) const {
+      int cx1 = cellIndex(x1), cx2 = cellIndex(x2);
+      int cy1 = cellIndex(y1), cy2 = cellIndex(y2);
+      double numCells = (double)(cx2-cx1+1)*(double)(cy2-cy1+1);
+      if(numCells > (double)entries.size()) {
+        // the rectangle covers more cells than we have items
+        typename std::unordered_map<T, Entry>::const_iterator it;
+        for(it=entries.begin(); it!=entries.end(); ++it) {
+          if(overlaps(it->second, x1, x2, y1, y2)) {
+            result->push_back(it->first);
+          }
+        }
+        return;
+      }
+      for(int cx=cx1; cx<=cx2; ++cx) {
+        for(int cy=cy1; cy<=cy2; ++cy) {
+          typename std::unordered_map<long long, std::vector<T> >::const_iterator it;
+          it = cells.find(cellKey(cx, cy));
+          if(it == cells.end()) continue;
+          typename std::vector<T>::const_iterator jt = it->second.begin();
+          for(; jt!=it->second.end(); ++jt) {
+            const Entry &e = entries.find(*jt)->second;
+            // an item spanning several cells is only reported by the
+            // first cell it shares with the query
+            if(cx != std::max(e.cx1, cx1) || cy != std::max(e.cy1, cy1)) {
+              continue;
+            }
+            if(overlaps(e, x1, x2, y1, y2)) {
+              result->push_back(*jt);
+            }
+          }
+        }
+      }
+    }
+
+    bool getRectangle(T item, double *x1, double *x2,
+                      double *y1, double *y2) const {
+      typename std::unordered_map<T, Entry>::const_iterator it = entries.find(item);
+      if(it == entries.end()) return false;
+      *x1 = it->second.x1;
+      *x2 = it->second.x2;
+      *y1 = it->second.y1;
+      *y2 = it->second.y2;
+      return true;
+    }
+
+  private:
+    struct Entry {
+      double x1, x2, y1, y2;
+      int cx1, cx2, cy1, cy2;
+    };
+
+    double cellSize;
+    std::unordered_map<T, Entry> entries;
+    std::unordered_map<long long, std::vector<T> > cells;
+
+    int cellIndex(double v) const {
+      return (int)floor(v / cellSize);
+    }
+
+    static long long cellKey(int cx, int cy) {
+      return ((long long)cx << 32) ^ (long long)(unsigned int)cy;
+    }
+
+    static bool overlaps(const Entry &e, double x1, double x2,
+                         double y1, double y2) {
+      return !(e.x2 < x1 || e.x1 > x2 || e.y2 < y1 || e.y1 > y2);
+    }
+
+    void addToCells(T item, const Entry &e) {
+      for(int cx=e.cx1; cx<=e.cx2; ++cx) {
+        for(int cy=e.cy1; cy<=e.cy2; ++cy) {
+          cells[cellKey(cx, cy)].push_back(item);
+        }
+      }
+    }
+
+    void removeFromCells(T item, const Entry &e) {
+      for(int cx=e.cx1; cx<=e.cx2; ++cx) {
+        for(int cy=e.cy1; cy<=e.cy2; ++cy) {
+          typename std::unordered_map<long long, std::vector<T> >::iterator it;
+          it = cells.find(cellKey(cx, cy));
+          if(it == cells.end()) continue;
+          std::vector<T> &cell = it->second;
+          for(size_t i=0; i<cell.size(); ++i) {
+            if(cell[i] == item) {
+              cell[i] = cell.back();
+              cell.pop_back();
+              break;
+            }
+          }
+          if(cell.empty()) cells.erase(it);
+        }
+      }
+    }
+  };
+
+} // end of namespace: osg_graph_viz
+
+#endif // OSG_GRAPH_VIZ_SPATIAL_GRID_HPP
@@ -0,0 +1,257 @@
+/**
+ * \file TextBatch.cpp
+ * \brief Draws the labels of a node as glyph quads from the shared font atlases.
+ */
+
+#include "TextBatch.hpp"
+#include "View.hpp"
+
+#include <osg/Version>
+#include <osgText/String>
+
+namespace osg_graph_viz {
+
+  TextBatch::TextBatch(View *view) : view(view), resolution(32) {
+    osg::StateSet *state = getOrCreateStateSet();
+    state->setMode(GL_BLEND, osg::StateAttribute::ON);
+    state->setMode(GL_LIGHTING, osg::StateAttribute::OFF);
+  }
+
+  void TextBatch::add(osg_text::Text *text, const osg::Vec4 &color) {
+    Label &label = labels[text];
+    label.text = text;
+    label.color = color;
+    label.visible = false;
+    label.valid = false;
+    // the label is only kept for the layout
+    ((osg::Node*)text->getOSGNode())->setNodeMask(0);
+  }
+
+  void TextBatch::sync(osg::Group *parent) {
+    std::map<osg_text::Text*, Label>::iterator it;
+    for(it=labels.begin(); it!=labels.end(); ++it) {
+      Label &label = it->second;
+      // a label has only a few parents, its node has many children
+      osg::Node *node = (osg::Node*)label.text->getOSGNode();
+      bool visible = false;
+      for(unsigned int i=0; !visible && i<node->getNumParents(); ++i) {
+        visible = (node->getParent(i) == parent);
+      }
+      std::string s = label.text->getText();
+      double x1, x2, y1, y2;
+      label.text->getRectangle(&x1, &x2, &y1, &y2);
+      if(label.valid && visible == label.visible &&
+         (!visible || (s == label.string && x1 == label.x && y1 == label.y))) {
+        continue;
+      }
+      label.string = s;
+      label.x = x1;
+      label.y = y1;
+      label.visible = visible;
+      label.valid = true;
+      write(label, visible);
+    }
+  }
+
+  void TextBatch::setFontResolution(unsigned int res) {
+    if(res == resolution) return;
+    resolution = res;
+    std::map<osg_text::Text*, Label>::iterator it;
+    for(it=labels.begin(); it!=labels.end(); ++it) {
+      it->second.valid = false;
+    }
+  }
+
+  void TextBatch::write(Label &label, bool visible) {
+    std::map<size_t, std::vector<Glyph> > quads;
+    osgText::Font *font = visible ? view->loadFont(label.text->getFont()) : NULL;
+    if(font) {
+      double l, r, t, b, pl, pt, pr, pb;
+      double size = label.text->getFontsize();
+      label.text->getRectangle(&l, &r, &t, &b);
+      label.text->getPadding(&pl, &pt, &pr, &pb);
+      osgText::FontResolution res(resolution, resolution);
+      // the labels are top aligned, the first base line is one ascender
+      // below the padding
+      float ascender = 0.8, descender = -0.2;
+#if OSG_VERSION_GREATER_OR_EQUAL(3, 6, 0)
+      // the metrics are scaled for the last requested resolution
+      font->getGlyph(res, 'A');
+      font->getVerticalSize(ascender, descender);
+#endif
+      osg::Vec3 cursor(l+pl, t-pt-ascender*size, 0.0);
+      osgText::String chars(label.string, osgText::String::ENCODING_UTF8);
+      for(size_t i=0; i<chars.size(); ++i) {
+        osgText::Glyph *glyph = font->getGlyph(res, chars[i]);
+        if(!glyph) continue;
+#if OSG_VERSION_GREATER_OR_EQUAL(3, 6, 0)
+        const osgText::Glyph::TextureInfo *info = glyph->getOrCreateTextureInfo(osgText::GREYSCALE);
+        osgText::GlyphTexture *texture = info ? info->texture.get() : NULL;
+#else
+        osgText::GlyphTexture *texture = glyph->getTexture();
+#endif
+        if(texture && glyph->getWidth() > 0) {
+          Glyph q;
+          osg::Vec2 bearing = glyph->getHorizontalBearing();
+          q.min = cursor + osg::Vec3(bearing.x()*size, bearing.y()*size, 0.0);
+          q.max = q.min + osg::Vec3(glyph->getWidth()*size,
+                                    glyph->getHeight()*size, 0.0);
+#if OSG_VERSION_GREATER_OR_EQUAL(3, 6, 0)
+          q.tcMin = info->minTexCoord;
+          q.tcMax = info->maxTexCoord;
+#else
+          q.tcMin = glyph->getMinTexCoord();
+          q.tcMax = glyph->getMaxTexCoord();
+#endif
+          quads[getPage(texture)].push_back(q);
+        }
+        cursor.x() += glyph->getHorizontalAdvance()*size;
+      }
+    }
+
+    // the quads are rewritten in place if the glyph count did not change
+    bool inPlace = label.ranges.size() == quads.size();
+    std::map<size_t, std::vector<Glyph> >::iterator it;
+    size_t k = 0;
+    for(it=quads.begin(); inPlace && it!=quads.end(); ++it, ++k) {
+      if(label.ranges[k].page != it->first ||
+         label.ranges[k].count != 6*it->second.size()) {
+        inPlace = false;
+      }
+    }
+    if(!inPlace) {
+      for(size_t i=0; i<label.ranges.size(); ++i) {
+        release(label.text.get(), label.ranges[i]);
+      }
+      label.ranges.clear();
+      for(it=quads.begin(); it!=quads.end(); ++it) {
+        label.ranges.push_back(allocate(label.text.get(), it->first,
+                                        6*it->second.size()));
+      }
+    }
+
+    for(it=quads.begin(), k=0; it!=quads.end(); ++it, ++k) {
+      const Range &range = label.ranges[k];
+      Page &p = pages[range.page];
+      for(size_t i=0; i<it->second.size(); ++i) {
+        const Glyph &q = it->second[i];
+        size_t n = range.first + 6*i;
+        osg::Vec3 v[4] = {q.min, osg::Vec3(q.max.x(), q.min.y(), 0.0),
+                          q.max, osg::Vec3(q.min.x(), q.max.y(), 0.0)};
+        osg::Vec2 tc[4] = {q.tcMin, osg::Vec2(q.tcMax.x(), q.tcMin.y()),
+                           q.tcMax, osg::Vec2(q.tcMin.x(), q.tcMax.y())};
+        const int corners[6] = {0, 1, 2, 0, 2, 3};
+        for(int c=0; c<6; ++c) {
+          (*p.vertices)[n+c] = v[corners[c]];
+          (*p.texcoords)[n+c] = tc[corners[c]];
+          (*p.colors)[n+c] = label.color;
+        }
+      }
+      dirtyPage(range.page);
+    }
+  }
+
+  size_t TextBatch::getPage(osgText::GlyphTexture *texture) {
+    std::map<osgText::GlyphTexture*, size_t>::iterator it = pageIndex.find(texture);
+    if(it != pageIndex.end()) return it->second;
+    Page p;
+    p.geom = new osg::Geometry;
+    p.geom->setDataVariance(osg::Object::DYNAMIC);
+    p.geom->setUseDisplayList(false);
+    p.geom->setUseVertexBufferObjects(true);
+    p.vertices = new osg::Vec3Array();
+    p.texcoords = new osg::Vec2Array();
+    p.colors = new osg::Vec4Array();
+    p.geom->setVertexArray(p.vertices.get());
+    p.geom->setTexCoordArray(0, p.texcoords.get());
+    p.geom->setColorArray(p.colors.get());
+    p.geom->setColorBinding(osg::Geometry::BIND_PER_VERTEX);
+    p.drawArrays = new osg::DrawArrays(osg::PrimitiveSet::TRIANGLES, 0, 0);
+    p.geom->addPrimitiveSet(p.drawArrays.get());
+    p.geom->getOrCreateStateSet()->setTextureAttributeAndModes(0, texture,
+                                                               osg::StateAttribute::ON);
+    p.waste = 0;
+    addDrawable(p.geom.get());
+    pages.push_back(p);
+    pageIndex[texture] = pages.size()-1;
+    return pages.size()-1;
+  }
+
+  TextBatch::Range TextBatch::allocate(osg_text::Text *text, size_t page,
+                                       size_t count) {
+    Page &p = pages[page];
+    Range r;
+    r.page = page;
+    r.first = p.vertices->size();
+    r.count = count;
+    p.vertices->resize(r.first + count);
+    p.texcoords->resize(r.first + count);
+    p.colors->resize(r.first + count);
+    p.labels.push_back(text);
+    return r;
+  }
+
+  void TextBatch::release(osg_text::Text *text, const Range &range) {
+    Page &p = pages[range.page];
+    // collapse the quads until the page is compacted
+    for(size_t i=range.first; i<range.first+range.count; ++i) {
+      (*p.vertices)[i] = (*p.vertices)[range.first];
+      (*p.colors)[i] = osg::Vec4(0, 0, 0, 0);
+    }
+    for(size_t i=0; i<p.labels.size(); ++i) {
+      if(p.labels[i] == text) {
+        p.labels[i] = p.labels.back();
+        p.labels.pop_back();
+        break;
+      }
+    }
+    p.waste += range.count;
+    if(2*p.waste > p.vertices->size()) {
+      compact(range.page);
+    }
+    dirtyPage(range.page);
+  }
+
+  void TextBatch::compact(size_t page) {
+    Page &p = pages[page];
+    osg::ref_ptr<osg::Vec3Array> vertices = new osg::Vec3Array();
+    osg::ref_ptr<osg::Vec2Array> texcoords = new osg::Vec2Array();
+    osg::ref_ptr<osg::Vec4Array> colors = new osg::Vec4Array();
+    vertices->reserve(p.vertices->size() - p.waste);
+    texcoords->reserve(p.vertices->size() - p.waste);
+    colors->reserve(p.vertices->size() - p.waste);
+    for(size_t i=0; i<p.labels.size(); ++i) {
+      std::vector<Range> &ranges = labels[p.labels[i]].ranges;
+      for(size_t k=0; k<ranges.size(); ++k) {
+        Range &r = ranges[k];
+        if(r.page != page) continue;
+        size_t first = vertices->size();
+        for(size_t n=r.first; n<r.first+r.count; ++n) {
+          vertices->push_back((*p.vertices)[n]);
+          texcoords->push_back((*p.texcoords)[n]);
+          colors->push_back((*p.colors)[n]);
+        }
+        r.first = first;
+      }
+    }
+    p.vertices = vertices;
+    p.texcoords = texcoords;
+    p.colors = colors;
+    p.geom->setVertexArray(vertices.get());
+    p.geom->setTexCoordArray(0, texcoords.get());
+    p.geom->setColorArray(colors.get());
+    p.geom->setColorBinding(osg::Geometry::BIND_PER_VERTEX);
+    p.waste = 0;
+  }
+
+  void TextBatch::dirtyPage(size_t page) {
+    Page &p = pages[page];
+    p.drawArrays->setCount(p.vertices->size());
+    p.drawArrays->dirty();
+    p.vertices->dirty();
+    p.texcoords->dirty();
+    p.colors->dirty();
+    p.geom->dirtyBound();
+  }
+
+} // end of namespace: osg_graph_viz
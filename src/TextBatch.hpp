@@ -0,0 +1,86 @@
+/**
+ * \file TextBatch.hpp
+ * \brief Draws the labels of a node as glyph quads from the shared font atlases.
+ **/
+
+#ifndef OSG_GRAPH_VIZ_TEXT_BATCH_HPP
+#define OSG_GRAPH_VIZ_TEXT_BATCH_HPP
+
+#include <osg/Geode>
+#include <osg/Geometry>
+#include <osgText/Font>
+
+#include <string>
+#include <vector>
+#include <map>
+
+#include <mars/osg_text/Text.h>
+
+namespace osg_graph_viz {
+
+  class View;
+
+  /**
+   * The osg_text labels registered here are still used for the layout and
+   * the svg export, but their own drawables are masked out. The batch
+   * draws their glyphs instead with one geometry per glyph texture of the
+   * fonts cached by the view. A label is drawn as long as its node is
+   * attached to the given parent, so the code adding and removing labels
+   * does not have to know about the batch. sync() compares the labels
+   * with the state of the last call and only rewrites the quads of the
+   * labels that have changed.
+   */
+  class TextBatch : public osg::Geode {
+
+  public:
+    TextBatch(View *view);
+
+    // the labels stay registered as long as the batch, which belongs to
+    // the node owning them
+    void add(osg_text::Text *label, const osg::Vec4 &color=osg::Vec4(0, 0, 0, 1));
+    void sync(osg::Group *parent);
+    void setFontResolution(unsigned int res);
+
+  private:
+    struct Page {
+      osg::ref_ptr<osg::Geometry> geom;
+      osg::ref_ptr<osg::Vec3Array> vertices;
+      osg::ref_ptr<osg::Vec2Array> texcoords;
+      osg::ref_ptr<osg::Vec4Array> colors;
+      osg::ref_ptr<osg::DrawArrays> drawArrays;
+      std::vector<osg_text::Text*> labels;
+      size_t waste;
+    };
+    struct Range {
+      size_t page, first, count;
+    };
+    struct Label {
+      osg::ref_ptr<osg_text::Text> text;
+      osg::Vec4 color;
+      std::string string;
+      double x, y;
+      bool visible, valid;
+      std::vector<Range> ranges;
+    };
+    struct Glyph {
+      osg::Vec3 min, max;
+      osg::Vec2 tcMin, tcMax;
+    };
+
+    View *view;
+    unsigned int resolution;
+    std::vector<Page> pages;
+    std::map<osgText::GlyphTexture*, size_t> pageIndex;
+    std::map<osg_text::Text*, Label> labels;
+
+    void write(Label &label, bool visible);
+    size_t getPage(osgText::GlyphTexture *texture);
+    Range allocate(osg_text::Text *text, size_t page, size_t count);
+    void release(osg_text::Text *text, const Range &range);
+    void compact(size_t page);
+    void dirtyPage(size_t page);
+  };
+
+} // end of namespace: osg_graph_viz
+
+#endif // OSG_GRAPH_VIZ_TEXT_BATCH_HPP
@@ -7,6 +7,8 @@
 #ifndef OSG_GRAPH_VIZ_UPDATE_INTERFACE_HPP
 #define OSG_GRAPH_VIZ_UPDATE_INTERFACE_HPP
 
+#include <vector>
+
 namespace osg_graph_viz {
 
   class Node;
@@ -36,6 +38,19 @@ namespace osg_graph_viz {
 			    const std::string &child) {return true;}
     virtual void undo() {}
     virtual void redo() {}
+    // called at most once per frame while a queued graph is built
+    virtual void loadProgress(size_t done, size_t total) {}
+    // the nodes and edges changed by the user since the last frame, by
+    // default forwarded to updateNode/updateEdge
+    virtual void nodesChanged(const std::vector<Node*> &nodes) {
+      for(size_t i=0; i<nodes.size(); ++i) updateNode(nodes[i]);
+    }
+    virtual void edgesChanged(const std::vector<Edge*> &edges) {
+      for(size_t i=0; i<edges.size(); ++i) updateEdge(edges[i]);
+    }
+    // called on mouse release with everything moved by the drag
+    virtual void dragFinished(const std::vector<Node*> &nodes,
+                              const std::vector<Edge*> &edges) {}
 
 
   };
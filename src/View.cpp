@@ -14,10 +14,17 @@
 #include <osg/Geode>
 #include <osg/LineWidth>
 #include <cstdio>
+#include <algorithm>
+#include <thread>
+#include <atomic>
+#include <mutex>
+#include <exception>
+#include <chrono>
 #include <osgDB/ReadFile>
 #include <mars/utils/misc.h>
 
 #include <mars/osg_material_manager/OsgMaterialManager.h>
+#include <mars/osg_material_manager/MaterialNode.h>
 #ifdef _WIN32
   #include <io.h>
 #endif
@@ -33,6 +40,50 @@ namespace osg_graph_viz {
   unsigned long View::labelID = 0;
   ConfigMap View::bufferMap;
 
+  // set while the thread builds nodes or edges for loadGraph, the view
+  // callbacks of the constructors are skipped then and loadGraph applies
+  // their effects on its own thread
+  static thread_local bool building = false;
+
+  struct BuildScope {
+    BuildScope() {building = true;}
+    ~BuildScope() {building = false;}
+  };
+
+  // calls fn(i) for every i < n, the indices are shared by the threads, the
+  // first exception of a worker is thrown again after all have joined
+  template <typename F>
+  static void parallelFor(size_t n, unsigned int threads, F fn) {
+    if(threads > n) threads = n;
+    if(threads <= 1) {
+      BuildScope scope;
+      for(size_t i=0; i<n; ++i) fn(i);
+      return;
+    }
+    std::atomic<size_t> next(0);
+    std::exception_ptr error;
+    std::mutex errorMutex;
+    std::vector<std::thread> workers;
+    for(unsigned int t=0; t<threads; ++t) {
+      workers.push_back(std::thread([&]() {
+        BuildScope scope;
+        try {
+          for(size_t i=next++; i<n; i=next++) fn(i);
+        }
+        catch(...) {
+          std::lock_guard<std::mutex> lock(errorMutex);
+          if(!error) error = std::current_exception();
+          // the other workers stop with their current index
+          next = n;
+        }
+      }));
+    }
+    for(size_t t=0; t<workers.size(); ++t) {
+      workers[t].join();
+    }
+    if(error) std::rethrow_exception(error);
+  }
+
   bool pathExists(const std::string &path) {
 #ifdef _WIN32
       return (_access(path.c_str(), 0) == 0);
@@ -71,6 +122,24 @@ namespace osg_graph_viz {
     inScale = false;
     resourcesPath = OSG_GRAPH_VIZ_DEFAULT_RESOURCES_PATH;
     resourcesPath += "/";
+    materialManager = NULL;
+    instancedBodies = false;
+    batchedEdges = false;
+    batchedText = false;
+    viewportCulling = false;
+    cullDirty = false;
+    textVisible = true;
+    textHideScale = 0.85;
+    textShowScale = 0.95;
+    farZoom = false;
+    farEnterScale = 0.3;
+    farLeaveScale = 0.35;
+    bundledEdges = false;
+    deferEdges = false;
+    loadThreads = 1;
+    loadNext = loadDone = loadTotal = 0;
+    loadBudget = 8.0;
+    updateDepth = 0;
   }
 
   View::~View(void) {
@@ -88,6 +157,7 @@ namespace osg_graph_viz {
     windowHeight = 1080;
     ui = NULL;
     lineMode = DIRECT_LINE_MODE;
+    selectionMode = SELECT_BY_ANCHOR;
     pressed = selecting = false;
     modKey = false;
     dontDeselectOnRelease = false;
@@ -108,12 +178,17 @@ namespace osg_graph_viz {
     cameraScale->setMatrix(osg::Matrix::scale(1., 1., 1.));
     //mainScale->addChild(mainPos.get());
     //this->addChild(mainScale.get());
+    preloadMaterials();
     materialManager->getMainStateGroup()->addChild(content.get());
     mainScale->addChild(materialManager->getMainStateGroup());
     mainPos->addChild(mainScale.get());
     cameraScale->addChild(mainPos.get());
     scene->addChild(cameraScale.get());
 
+    // only shown while zoomed out
+    flatBatch = new FlatNodeBatch();
+    flatBatch->setNodeMask(0);
+    content->addChild(flatBatch.get());
 
     osg_text::Color c(0., 0., 0., 1.0);
     infoText = new osg_text::Text("mouse [] ...", 15, c, 10, 1055,
@@ -126,11 +201,14 @@ namespace osg_graph_viz {
     mouseMask = 0;
     nodeToMove = 0;
     renderBin = 30;
+    pickCounter = 0;
     addEdge = false;
 
 
     selectionGeode = new osg::Geode;
     selectionGeom = new osg::Geometry;
+    selectionGeom->setUseDisplayList(false);
+    selectionGeom->setUseVertexBufferObjects(true);
 
     selectionVertices = new osg::Vec3Array();
     selectionVertices->push_back(osg::Vec3(0, 0, 0.0));
@@ -160,7 +238,7 @@ namespace osg_graph_viz {
     //mainScale->addChild(selectionGeode.get());
   }
 
-  Node* View::createNode(const NodeInfo &info) {
+  Node* View::constructNode(const NodeInfo &info) {
     Node *bgNode;
     ConfigMap map = info.map;
     if(map.hasKey("NodeClass")) {
@@ -184,7 +262,45 @@ namespace osg_graph_viz {
         bgNode = new Node(info, this);
       }
     }
-    nodeList.push_front(bgNode);
+    return bgNode;
+  }
+
+  void View::registerNode(Node *node) {
+    nodeList.push_front(node);
+    node->listHandle = nodeList.begin();
+    node->inNodeList = true;
+    node->pickOrder = ++pickCounter;
+    nameIndex.insert(std::make_pair(node->getName(), node));
+  }
+
+  Node* View::findNodeByName(const std::string &name) {
+    Node *node = NULL;
+    std::pair<std::unordered_multimap<std::string, Node*>::iterator,
+              std::unordered_multimap<std::string, Node*>::iterator> range;
+    range = nameIndex.equal_range(name);
+    for(; range.first!=range.second; ++range.first) {
+      Node *n = range.first->second;
+      if(!node || n->pickOrder > node->pickOrder) node = n;
+    }
+    return node;
+  }
+
+  void View::eraseNodeName(const std::string &name, Node *node) {
+    std::pair<std::unordered_multimap<std::string, Node*>::iterator,
+              std::unordered_multimap<std::string, Node*>::iterator> range;
+    range = nameIndex.equal_range(name);
+    for(; range.first!=range.second; ++range.first) {
+      if(range.first->second == node) {
+        nameIndex.erase(range.first);
+        return;
+      }
+    }
+  }
+
+  Node* View::createNode(const NodeInfo &info) {
+    Node *bgNode = constructNode(info);
+    registerNode(bgNode);
+    ConfigMap map = info.map;
     if(map.hasKey("parentName")) {
       osg::ref_ptr<Node> parent = getNodeByName((std::string)map["parentName"]);
       if(parent) {
@@ -201,25 +317,501 @@ namespace osg_graph_viz {
       content->addChild(bgNode);
       bgNode->setRenderOrder(++renderBin);
     }
+    double x1, x2, y1, y2;
+    bgNode->getWorldRectangle(&x1, &x2, &y1, &y2);
+    nodeIndex.insert(bgNode, x1, x2, y1, y2);
+    syncNewNode(bgNode);
+    // the parent is known now, update the world placement of the node
+    bgNode->updateBounds();
     return bgNode;
   }
 
+  void View::loadGraph(const ConfigMap &graph_) {
+    ConfigMap graph = graph_;
+    std::vector<Node*> nodes;
+    std::vector<osg::Node*> attach;
+    size_t numNodes = graph.hasKey("nodes") ? graph["nodes"].size() : 0;
+    size_t numEdges = graph.hasKey("edges") ? graph["edges"].size() : 0;
+    nodes.reserve(numNodes);
+    attach.reserve(numNodes+numEdges);
+
+    unsigned int threads = loadThreads;
+    if(threads == 0) threads = std::max(std::thread::hardware_concurrency(), 1u);
+    std::vector<NodeInfo> infos(numNodes);
+    for(size_t i=0; i<numNodes; ++i) {
+      NodeInfo &info = infos[i];
+      info.map = graph["nodes"][i];
+      info.numInputs = info.map.hasKey("inputs") ? info.map["inputs"].size() : 0;
+      info.numOutputs = info.map.hasKey("outputs") ? info.map["outputs"].size() : 0;
+      info.redrawEdges = false;
+      if(info.map.hasKey("type")) info.type << info.map["type"];
+    }
+    // created here, the workers only add their nodes
+    getRoundBodyBatch();
+
+    // build all nodes detached from the scene
+    nodes.resize(numNodes);
+    parallelFor(numNodes, threads, [&](size_t i) {
+        nodes[i] = constructNode(infos[i]);
+        nodes[i]->setLayoutDeferred(true);
+      });
+    for(size_t i=0; i<numNodes; ++i) {
+      registerNode(nodes[i]);
+    }
+
+    // the parents can be listed after their children
+    for(size_t i=0; i<nodes.size(); ++i) {
+      Node *node = nodes[i];
+      bool hasParent = false;
+      if(node->info.map.hasKey("parentName")) {
+        std::string parentName = node->info.map["parentName"];
+        Node *parent = findNodeByName(parentName);
+        if(parent && parent != node) {
+          parent->addChildNode(node);
+          node->setParentNode(parent);
+          hasParent = true;
+        }
+      }
+      if(!hasParent) attach.push_back(node);
+    }
+    for(size_t i=0; i<nodes.size(); ++i) {
+      ConfigMap &map = nodes[i]->info.map;
+      if(map.hasKey("pos")) {
+        nodes[i]->setPosition(map["pos"]["x"], map["pos"]["y"]);
+      }
+    }
+
+    // the end points are resolved by the node and port names
+    struct PendingEdge {
+      ConfigMap map;
+      Node *from, *to;
+      int idx1, idx2;
+      Edge *edge;
+    };
+    std::vector<PendingEdge> pending;
+    pending.reserve(numEdges);
+    for(size_t i=0; i<numEdges; ++i) {
+      PendingEdge p;
+      p.map = graph["edges"][i];
+      p.from = findNodeByName(p.map["fromNode"].getString());
+      p.to = findNodeByName(p.map["toNode"].getString());
+      if(!p.from || !p.to) {
+        fprintf(stderr, "loadGraph: skip edge with unknown node\n");
+        continue;
+      }
+      p.idx1 = p.from->getOutPortIndex(p.map["fromNodeOutput"].getString());
+      p.idx2 = p.to->getInPortIndex(p.map["toNodeInput"].getString());
+      if(p.idx1 < 0 || p.idx2 < 0) {
+        fprintf(stderr, "loadGraph: skip edge with unknown port\n");
+        continue;
+      }
+      pending.push_back(p);
+    }
+    parallelFor(pending.size(), threads, [&](size_t i) {
+        pending[i].edge = new Edge(pending[i].map, this, mergeIconSize);
+      });
+    // connecting the edges touches both nodes, this stays on this thread
+    for(size_t i=0; i<pending.size(); ++i) {
+      PendingEdge &p = pending[i];
+      p.edge->fromIdx = p.idx1;
+      p.edge->toIdx = p.idx2;
+      addEdgeToList(p.edge);
+      p.from->addOutputEdge(p.idx1, p.edge);
+      p.to->addInputEdge(p.idx2, p.edge);
+      attach.push_back(p.edge);
+    }
+
+    // every node is laid out once with all of its edges
+    for(size_t i=0; i<nodes.size(); ++i) {
+      nodes[i]->setLayoutDeferred(false);
+    }
+    for(size_t i=0; i<attach.size(); ++i) {
+      content->addChild(attach[i]);
+      Node *node = dynamic_cast<Node*>(attach[i]);
+      if(node) node->setRenderOrder(++renderBin);
+    }
+    for(size_t i=0; i<nodes.size(); ++i) {
+      double x1, x2, y1, y2;
+      nodes[i]->getWorldRectangle(&x1, &x2, &y1, &y2);
+      nodeIndex.insert(nodes[i], x1, x2, y1, y2);
+      syncNewNode(nodes[i]);
+      nodes[i]->updateBounds();
+    }
+  }
+
+  void View::queueGraph(const ConfigMap &graph_) {
+    ConfigMap graph = graph_;
+    size_t numNodes = graph.hasKey("nodes") ? graph["nodes"].size() : 0;
+    size_t numEdges = graph.hasKey("edges") ? graph["edges"].size() : 0;
+    std::vector<NodeInfo> infos(numNodes);
+    std::unordered_map<std::string, size_t> names;
+    for(size_t i=0; i<numNodes; ++i) {
+      NodeInfo &info = infos[i];
+      info.map = graph["nodes"][i];
+      info.numInputs = info.map.hasKey("inputs") ? info.map["inputs"].size() : 0;
+      info.numOutputs = info.map.hasKey("outputs") ? info.map["outputs"].size() : 0;
+      info.redrawEdges = false;
+      if(info.map.hasKey("type")) info.type << info.map["type"];
+      names[info.map["name"].getString()] = i;
+    }
+
+    // the children follow their top level node, the top level nodes are
+    // sorted by their distance to the center of the visible area
+    double x1, x2, y1, y2;
+    getVisibleRect(&x1, &x2, &y1, &y2);
+    double cx = (x1+x2)*0.5, cy = (y1+y2)*0.5;
+    std::vector<std::pair<double, int> > keys(numNodes);
+    for(size_t i=0; i<numNodes; ++i) {
+      size_t top = i;
+      int depth = 0;
+      while(infos[top].map.hasKey("parentName") && depth < (int)numNodes) {
+        std::unordered_map<std::string, size_t>::iterator it;
+        it = names.find(infos[top].map["parentName"].getString());
+        if(it == names.end()) break;
+        top = it->second;
+        ++depth;
+      }
+      double dx = 0, dy = 0;
+      if(infos[top].map.hasKey("pos")) {
+        dx = (double)infos[top].map["pos"]["x"] - cx;
+        dy = (double)infos[top].map["pos"]["y"] - cy;
+      }
+      keys[i] = std::make_pair(dx*dx+dy*dy, depth);
+    }
+    std::vector<size_t> order(numNodes);
+    for(size_t i=0; i<numNodes; ++i) order[i] = i;
+    std::stable_sort(order.begin(), order.end(),
+                     [&](size_t a, size_t b) {return keys[a] < keys[b];});
+
+    // drop the already loaded part of a previous queue
+    loadNodes.erase(loadNodes.begin(), loadNodes.begin()+loadNext);
+    loadNext = 0;
+    for(size_t i=0; i<numNodes; ++i) {
+      loadNodes.push_back(infos[order[i]]);
+    }
+
+    // an edge is ready once its last end node is built
+    for(size_t i=0; i<numEdges; ++i) {
+      QueuedEdge edge;
+      edge.map = graph["edges"][i];
+      edge.missing = 0;
+      std::string ends[2] = {edge.map["fromNode"].getString(),
+                             edge.map["toNode"].getString()};
+      bool known = true;
+      bool queued[2];
+      for(int n=0; n<2; ++n) {
+        queued[n] = names.find(ends[n]) != names.end();
+        if(queued[n]) ++edge.missing;
+        else if(nameIndex.find(ends[n]) == nameIndex.end()) known = false;
+      }
+      if(!known) {
+        fprintf(stderr, "queueGraph: skip edge with unknown node\n");
+        continue;
+      }
+      // the index is only valid once the edge is accepted
+      for(int n=0; n<2; ++n) {
+        if(queued[n]) loadWaiting[ends[n]].push_back(loadEdges.size());
+      }
+      if(edge.missing == 0) loadReady.push_back(loadEdges.size());
+      loadEdges.push_back(edge);
+      ++loadTotal;
+    }
+    loadTotal += numNodes;
+  }
+
+  void View::loadStep() {
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    std::unordered_set<Node*> touched;
+    size_t done = loadDone;
+    do {
+      if(!loadReady.empty()) {
+        QueuedEdge &queued = loadEdges[loadReady.back()];
+        loadReady.pop_back();
+        ++loadDone;
+        osg::ref_ptr<Node> from = getNodeByName(queued.map["fromNode"].getString());
+        osg::ref_ptr<Node> to = getNodeByName(queued.map["toNode"].getString());
+        if(!from.valid() || !to.valid()) continue;
+        int idx1 = from->getOutPortIndex(queued.map["fromNodeOutput"].getString());
+        int idx2 = to->getInPortIndex(queued.map["toNodeInput"].getString());
+        if(idx1 < 0 || idx2 < 0) continue;
+        // the ports of a node are laid out once per frame
+        if(touched.insert(from.get()).second) from->setLayoutDeferred(true);
+        if(touched.insert(to.get()).second) to->setLayoutDeferred(true);
+        Edge *edge = createEdge(queued.map, idx1, idx2);
+        from->addOutputEdge(idx1, edge);
+        to->addInputEdge(idx2, edge);
+        queued.map = ConfigMap();
+      }
+      else if(loadNext < loadNodes.size()) {
+        NodeInfo &info = loadNodes[loadNext++];
+        ++loadDone;
+        Node *node = createNode(info);
+        if(info.map.hasKey("pos")) {
+          node->setPosition(info.map["pos"]["x"], info.map["pos"]["y"]);
+        }
+        std::unordered_map<std::string, std::vector<size_t> >::iterator it;
+        it = loadWaiting.find(node->getName());
+        if(it != loadWaiting.end()) {
+          for(size_t i=0; i<it->second.size(); ++i) {
+            if(--loadEdges[it->second[i]].missing == 0) {
+              loadReady.push_back(it->second[i]);
+            }
+          }
+          loadWaiting.erase(it);
+        }
+        info.map = ConfigMap();
+      }
+      else {
+        break;
+      }
+    } while(std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now()-start).count() < loadBudget);
+
+    std::unordered_set<Node*>::iterator it;
+    for(it=touched.begin(); it!=touched.end(); ++it) {
+      (*it)->setLayoutDeferred(false);
+    }
+    bool finished = loadNext == loadNodes.size() && loadReady.empty();
+    if(ui && loadDone != done) {
+      ui->loadProgress(loadDone, loadTotal);
+    }
+    if(finished) {
+      // edges waiting for nodes that never came are dropped
+      loadNodes.clear();
+      loadEdges.clear();
+      loadWaiting.clear();
+      loadNext = loadDone = loadTotal = 0;
+    }
+  }
+
   void View::removeNodeFromView(osg::ref_ptr<osg::Node> node) {
+    if(building) return;
     content->removeChild(node.get());
   }
 
   void View::addNodeToView(osg::ref_ptr<osg::Node> node) {
+    if(building) return;
     content->addChild(node.get());
   }
 
   osg::ref_ptr<osg_graph_viz::Node> View::getNodeByName(const std::string &name) {
-    std::list<osg::ref_ptr<osg_graph_viz::Node> >::iterator it = nodeList.begin();
-    for(; it!=nodeList.end(); ++it) {
-      if((*it)->getName() == name) {
-        return *it;
+    return findNodeByName(name);
+  }
+
+  void View::updateNodeName(const std::string &oldName, Node *node) {
+    if(building) return;
+    std::string name = node->getName();
+    if(name == oldName) return;
+    if(!node->inNodeList) {
+      // the node is not managed by the view
+      return;
+    }
+    eraseNodeName(oldName, node);
+    nameIndex.insert(std::make_pair(name, node));
+  }
+
+  void View::updateNodeBounds(Node *node) {
+    if(building || !nodeIndex.contains(node)) return;
+    if(updateDepth > 0) {
+      boundsNodes.insert(node);
+      return;
+    }
+    cullDirty = true;
+    double x1, x2, y1, y2;
+    node->getWorldRectangle(&x1, &x2, &y1, &y2);
+    nodeIndex.insert(node, x1, x2, y1, y2);
+    updateFlatNode(node);
+    if(bundler.valid()) {
+      bundler->nodeChanged(node);
+    }
+  }
+
+  void View::updateFlatNode(Node *node) {
+    if(building || !nodeIndex.contains(node)) return;
+    double x1, x2, y1, y2;
+    node->getWorldRectangle(&x1, &x2, &y1, &y2);
+    osg::Vec4 c(0.82, 0.87, 1.0, 1.0);
+    if(node->selected) {
+      c = osg::Vec4(0.72, 1.0, 0.77, 1.0);
+    }
+    else if(node->bColors.valid() && !node->bColors->empty()) {
+      c = (*node->bColors.get())[0];
+    }
+    if(node->hidden) c.a() = 0.0;
+    flatBatch->update(node, x1, x2, y1, y2, c);
+  }
+
+  void View::getNodesAt(double x, double y, std::vector<Node*> *nodes) {
+    size_t first = nodes->size();
+    nodeIndex.queryPoint(x, y, nodes);
+    // keep the order of the node list: the last raised node wins
+    std::sort(nodes->begin()+first, nodes->end(),
+              [](const Node *a, const Node *b) {
+                return a->pickOrder > b->pickOrder;
+              });
+  }
+
+  void View::updateEdgeBounds(Edge *edge) {
+    if(building || !edgeIndex.contains(edge)) return;
+    if(updateDepth > 0) {
+      boundsEdges.insert(edge);
+      return;
+    }
+    cullDirty = true;
+    std::vector<PickBox> boxes;
+    edge->getPickBoxes(&boxes);
+    edgeIndex.update(edge, boxes);
+  }
+
+  void View::updateEdgeBundle(Edge *edge) {
+    if(!building && bundler.valid() && edge->inEdgeList) {
+      bundler->add(edge);
+    }
+  }
+
+  bool View::deferEdgeUpdate(Node *node) {
+    // a node under construction has no edges yet
+    if(building) return true;
+    if(!deferEdges && updateDepth == 0) return false;
+    edgeUpdateNodes.insert(node);
+    return true;
+  }
+
+  bool View::deferLayout(Node *node) {
+    if(building || updateDepth == 0) return false;
+    layoutNodes.insert(node);
+    return true;
+  }
+
+  void View::beginUpdate() {
+    ++updateDepth;
+  }
+
+  void View::endUpdate() {
+    if(updateDepth == 0) return;
+    if(updateDepth > 1) {
+      --updateDepth;
+      return;
+    }
+    // the layout changes the port positions and bounds, which are still
+    // collected here
+    std::unordered_set<Node*> nodes;
+    nodes.swap(layoutNodes);
+    std::unordered_set<Node*>::iterator it;
+    for(it=nodes.begin(); it!=nodes.end(); ++it) {
+      (*it)->relayout();
+    }
+    updateDepth = 0;
+    flushEdgeUpdates();
+    nodes.clear();
+    nodes.swap(boundsNodes);
+    for(it=nodes.begin(); it!=nodes.end(); ++it) {
+      updateNodeBounds(*it);
+    }
+    std::unordered_set<Edge*> edges;
+    edges.swap(boundsEdges);
+    std::unordered_set<Edge*>::iterator et;
+    for(et=edges.begin(); et!=edges.end(); ++et) {
+      updateEdgeBounds(*et);
+    }
+  }
+
+  void View::notifyNode(Node *node) {
+    changedNodes.insert(node);
+  }
+
+  void View::notifyEdge(Edge *edge) {
+    changedEdges.insert(edge);
+  }
+
+  void View::flushChanges() {
+    if(changedNodes.empty() && changedEdges.empty()) return;
+    std::vector<Node*> nodes(changedNodes.begin(), changedNodes.end());
+    std::vector<Edge*> edges(changedEdges.begin(), changedEdges.end());
+    changedNodes.clear();
+    changedEdges.clear();
+    if(!ui) return;
+    if(!nodes.empty()) ui->nodesChanged(nodes);
+    if(!edges.empty()) ui->edgesChanged(edges);
+  }
+
+  void View::flushEdgeUpdates() {
+    if(edgeUpdateNodes.empty()) return;
+    // an edge between two moved nodes gets both ends in one update
+    std::unordered_map<Edge*, EdgeEndPoints> points;
+    std::unordered_set<Node*>::iterator it;
+    for(it=edgeUpdateNodes.begin(); it!=edgeUpdateNodes.end(); ++it) {
+      (*it)->getEdgeEndPoints(&points);
+    }
+    edgeUpdateNodes.clear();
+    std::unordered_map<Edge*, EdgeEndPoints>::iterator et;
+    for(et=points.begin(); et!=points.end(); ++et) {
+      et->first->updateEndPoints(et->second);
+    }
+  }
+
+  void View::getEdgesAt(double x, double y, std::vector<Edge*> *edges) {
+    size_t first = edges->size();
+    edgeIndex.queryPoint(x, y, edges);
+    // edges are only added at the front of the edge list
+    std::sort(edges->begin()+first, edges->end(),
+              [](const Edge *a, const Edge *b) {
+                return a->pickOrder > b->pickOrder;
+              });
+  }
+
+  void View::addEdgeToList(Edge *edge) {
+    std::vector<PickBox> boxes;
+    edgeList.push_front(edge);
+    edge->listHandle = edgeList.begin();
+    edge->inEdgeList = true;
+    if(!textVisible) edge->derenderText(false);
+    if(straightEdges()) edge->setFarZoom(true);
+    if(showBundles()) edge->setNodeMask(0);
+    if(viewportCulling) {
+      edge->setNodeMask(0);
+      cullDirty = true;
+    }
+    if(bundler.valid()) {
+      bundler->add(edge);
+    }
+    if(batchedEdges) {
+      if(!edgeBatch.valid()) {
+        edgeBatch = new EdgeBatch();
+        edgeBatch->setLineWidth(scale*0.5);
+        if(showBundles()) edgeBatch->setNodeMask(0);
+        content->insertChild(0, edgeBatch.get());
       }
+      edge->setEdgeBatch(edgeBatch.get());
+    }
+    edge->pickOrder = ++pickCounter;
+    edge->getPickBoxes(&boxes);
+    edgeIndex.update(edge, boxes);
+  }
+
+  void View::raiseNode(Node *node) {
+    if(node->inNodeList) {
+      // splicing keeps the handle valid
+      nodeList.splice(nodeList.begin(), nodeList, node->listHandle);
+    }
+    else {
+      nodeList.push_front(node);
+      node->listHandle = nodeList.begin();
+      node->inNodeList = true;
+      nameIndex.insert(std::make_pair(node->getName(), node));
+      syncNewNode(node);
+    }
+    node->pickOrder = ++pickCounter;
+    node->setRenderOrder(++renderBin);
+  }
+
+  void View::syncNewNode(Node *node) {
+    if(!textVisible) node->derenderText(false);
+    if(farZoom) node->setNodeMask(0);
+    if(viewportCulling) {
+      // shown by the next update if it is inside the visible area
+      node->setNodeMask(0);
+      cullDirty = true;
     }
-    return osg::ref_ptr<Node>();
   }
 
   osg_graph_viz::Edge* View::createEdge(const ConfigMap &info,
@@ -227,7 +819,7 @@ namespace osg_graph_viz {
     Edge *bgEdge = new Edge(info, this, mergeIconSize);
     bgEdge->fromIdx = idx1;
     bgEdge->toIdx = idx2;
-    edgeList.push_front(bgEdge);
+    addEdgeToList(bgEdge);
     content->addChild(bgEdge);
     bgEdge->getOrCreateStateSet()->setRenderBinDetails(renderBin,
                                                        "RenderBin");
@@ -235,6 +827,7 @@ namespace osg_graph_viz {
   }
 
   osg::Texture2D* View::loadTexture(const std::string &file) {
+    std::lock_guard<std::mutex> lock(resourceMutex);
     if(texMap.find(file) == texMap.end()) {
       osg::Texture2D *texture = new osg::Texture2D();
       texture->setDataVariance(osg::Object::DYNAMIC);
@@ -247,55 +840,352 @@ namespace osg_graph_viz {
     return texMap[file];
   }
 
+  osgText::Font* View::loadFont(const std::string &file) {
+    std::lock_guard<std::mutex> lock(resourceMutex);
+    std::map<std::string, osg::ref_ptr<osgText::Font> >::iterator it;
+    it = fontMap.find(file);
+    if(it == fontMap.end()) {
+      it = fontMap.insert(std::make_pair(file, osgText::readRefFontFile(file))).first;
+    }
+    return it->second.get();
+  }
+
+  void View::setResourcesPath(std::string path) {
+    resourcesPath = path;
+    materialMap.clear();
+    if(materialManager) {
+      preloadMaterials();
+    }
+  }
+
+  // load the shaders before the first node is created
+  void View::preloadMaterials() {
+    loadMaterial("round_rect");
+    loadMaterial("smooth_edge");
+  }
+
+  RoundBodyBatch* View::getRoundBodyBatch() {
+    if(!instancedBodies) return NULL;
+    std::lock_guard<std::mutex> lock(resourceMutex);
+    if(!bodyBatch.valid()) {
+      std::string loadPath = resourcesPath;
+      if(loadPath[loadPath.size()-1] != '/') loadPath.append("/");
+      bodyBatch = new RoundBodyBatch(loadPath + "shader/");
+      bodyBatch->setEnabled(!farZoom);
+      content->insertChild(0, bodyBatch.get());
+    }
+    return bodyBatch.get();
+  }
+
+  osg::StateSet* View::loadMaterial(const std::string &name) {
+    std::lock_guard<std::mutex> lock(resourceMutex);
+    if(materialMap.find(name) == materialMap.end()) {
+      std::string loadPath = resourcesPath;
+      if(loadPath[loadPath.size()-1] != '/') loadPath.append("/");
+      loadPath.append("shader/");
+      ConfigMap mMap = ConfigMap::fromYamlFile(loadPath + name + ".yml");
+      mMap["loadPath"] = loadPath;
+      materialManager->createMaterial(name, mMap);
+      osg::ref_ptr<osg::Node> materialGroup = materialManager->getNewMaterialGroup(name);
+      osg_material_manager::MaterialNode *materialNode = dynamic_cast<osg_material_manager::MaterialNode*>(materialGroup.get());
+      materialMap[name] = materialNode->getMaterial()->getOrCreateStateSet();
+    }
+    return materialMap[name];
+  }
+
   void View::update(void) {
     // for(int i=0; i<4; ++i) {
     //   if(scrollScale[i] > 1.0) scrollScale[i] -= 1;
     // }
+    if(loadNext < loadNodes.size() || !loadReady.empty()) {
+      loadStep();
+    }
+    if(updateDepth == 0) {
+      flushEdgeUpdates();
+      flushChanges();
+    }
+    if(viewportCulling) {
+      if(cullDirty || posX != cullPosX || posY != cullPosY ||
+         scale != cullScale || scaleRatio != cullScaleRatio) {
+        updateCulling();
+      }
+    }
+    if(showBundles()) {
+      bundler->setScale(scale, scaleRatio);
+      bundler->sync();
+    }
   }
 
-  void View::scaleView(double newScale, double x, double y) {
-    double lastMX = (mouseX*1920 - posX) / scale;
-    double lastMY = (mouseY*1080 - posY) / (scale*scaleRatio);
-    scale = newScale;
-    inScale = true;
-    if(scale < 0.9){ //if the scaling is to low, functions to derender all texts (Ports, NodeNames, and weights of edges)
+  void View::setViewportCulling(bool v) {
+    if(v == viewportCulling) return;
+    viewportCulling = v;
+    std::list<osg::ref_ptr<osg_graph_viz::Node> >::iterator it;
+    std::list<osg::ref_ptr<osg_graph_viz::Edge> >::iterator it2;
+    for(it=nodeList.begin(); it!=nodeList.end(); ++it) {
+      if(v) {
+        (*it)->setNodeMask(0);
+      }
+      else if(visibleNodes.find(it->get()) == visibleNodes.end()) {
+        (*it)->setNodeMask(farZoom ? 0 : ~0u);
+        (*it)->setLineWidth(scale*0.5);
+        (*it)->derenderText(textVisible);
+      }
+    }
+    for(it2=edgeList.begin(); it2!=edgeList.end(); ++it2) {
+      if(v) {
+        (*it2)->setNodeMask(0);
+      }
+      else if(visibleEdges.find(it2->get()) == visibleEdges.end()) {
+        (*it2)->setNodeMask(showBundles() ? 0 : ~0u);
+        (*it2)->setLineWidth(scale*0.5);
+        (*it2)->derenderText(textVisible);
+        (*it2)->setFarZoom(straightEdges());
+      }
+    }
+    visibleNodes.clear();
+    visibleEdges.clear();
+    if(v) {
+      updateCulling();
+    }
+  }
 
-      std::list<osg::ref_ptr<osg_graph_viz::Node> >::iterator it;
-      std::list<osg::ref_ptr<osg_graph_viz::Edge> >::iterator it2;
-      for(it=nodeList.begin(); it!=nodeList.end(); ++it) {
-        (*it)->derenderText(false);
+  void View::getVisibleRect(double *x1, double *x2, double *y1, double *y2) {
+    double a = -posY / (scale*scaleRatio);
+    double b = (1080 - posY) / (scale*scaleRatio);
+    *x1 = -posX / scale;
+    *x2 = (1920 - posX) / scale;
+    *y1 = std::min(a, b);
+    *y2 = std::max(a, b);
+  }
+
+  void View::updateCulling() {
+    double x1, x2, y1, y2, mx, my;
+    std::vector<Node*> nodes;
+    std::vector<Edge*> edges;
+    getVisibleRect(&x1, &x2, &y1, &y2);
+    // the margin keeps elements attached while they are panned in
+    mx = (x2-x1)*0.25;
+    my = (y2-y1)*0.25;
+    nodeIndex.queryRect(x1-mx, x2+mx, y1-my, y2+my, &nodes);
+    edgeIndex.queryRect(x1-mx, x2+mx, y1-my, y2+my, &edges);
+
+    std::unordered_set<Node*> nodeSet(nodes.begin(), nodes.end());
+    std::unordered_set<Node*>::iterator it;
+    for(it=visibleNodes.begin(); it!=visibleNodes.end(); ++it) {
+      if(nodeSet.find(*it) == nodeSet.end()) {
+        (*it)->setNodeMask(0);
       }
-      for(it2=edgeList.begin(); it2!=edgeList.end(); ++it2) {
-        (*it2)->derenderText(false);
+    }
+    for(it=nodeSet.begin(); it!=nodeSet.end(); ++it) {
+      if(visibleNodes.find(*it) == visibleNodes.end()) {
+        // the node missed the zoom updates while it was culled
+        (*it)->setNodeMask(farZoom ? 0 : ~0u);
+        (*it)->setLineWidth(scale*0.5);
+        (*it)->derenderText(textVisible);
       }
     }
-    if(scale > 0.9){ //if the scaling gets bigger every thing is reverted, and shown again.
-      std::list<osg::ref_ptr<osg_graph_viz::Node> >::iterator it;
-      std::list<osg::ref_ptr<osg_graph_viz::Edge> >::iterator it2;
-      for(it=nodeList.begin(); it!=nodeList.end(); ++it) {
-        (*it)->derenderText(true);
+    visibleNodes.swap(nodeSet);
+
+    std::unordered_set<Edge*> edgeSet(edges.begin(), edges.end());
+    std::unordered_set<Edge*>::iterator it2;
+    for(it2=visibleEdges.begin(); it2!=visibleEdges.end(); ++it2) {
+      if(edgeSet.find(*it2) == edgeSet.end()) {
+        (*it2)->setNodeMask(0);
+      }
+    }
+    for(it2=edgeSet.begin(); it2!=edgeSet.end(); ++it2) {
+      if(visibleEdges.find(*it2) == visibleEdges.end()) {
+        (*it2)->setNodeMask(showBundles() ? 0 : ~0u);
+        (*it2)->setLineWidth(scale*0.5);
+        (*it2)->derenderText(textVisible);
+        (*it2)->setFarZoom(straightEdges());
+      }
+    }
+    visibleEdges.swap(edgeSet);
+
+    cullPosX = posX;
+    cullPosY = posY;
+    cullScale = scale;
+    cullScaleRatio = scaleRatio;
+    cullDirty = false;
+  }
+
+  void View::setTextLodThresholds(double hide, double show) {
+    textHideScale = hide;
+    textShowScale = show < hide ? hide : show;
+    if(textVisible && scale < textHideScale) {
+      setTextVisible(false);
+    }
+    else if(!textVisible && scale > textShowScale) {
+      setTextVisible(true);
+    }
+  }
+
+  void View::setFarZoomThresholds(double enter, double leave) {
+    farEnterScale = enter;
+    farLeaveScale = leave < enter ? enter : leave;
+    if(!farZoom && scale < farEnterScale) {
+      setFarZoom(true);
+    }
+    else if(farZoom && scale > farLeaveScale) {
+      setFarZoom(false);
+    }
+  }
+
+  void View::setBundledEdges(bool v) {
+    if(v == bundledEdges) return;
+    bundledEdges = v;
+    if(v) {
+      bundler = new EdgeBundler();
+      content->insertChild(0, bundler.get());
+      std::list<osg::ref_ptr<osg_graph_viz::Edge> >::iterator it;
+      for(it=edgeList.begin(); it!=edgeList.end(); ++it) {
+        bundler->add(it->get());
+      }
+    }
+    else {
+      content->removeChild(bundler.get());
+      bundler = NULL;
+    }
+    if(farZoom) {
+      // the edges only draw their straight line without bundles
+      applyBundles();
+      setFarZoom(true);
+    }
+  }
+
+  void View::applyBundles() {
+    unsigned int mask = showBundles() ? 0 : ~0u;
+    if(bundler.valid()) {
+      bundler->setNodeMask(~mask);
+      if(showBundles()) {
+        bundler->setScale(scale, scaleRatio);
+        bundler->sync();
       }
-      for(it2=edgeList.begin(); it2!=edgeList.end(); ++it2) {
-        (*it2)->derenderText(true);
+    }
+    if(edgeBatch.valid()) {
+      edgeBatch->setNodeMask(mask);
+    }
+    if(viewportCulling) {
+      std::unordered_set<Edge*>::iterator it;
+      for(it=visibleEdges.begin(); it!=visibleEdges.end(); ++it) {
+        (*it)->setNodeMask(mask);
+      }
+      return;
+    }
+    std::list<osg::ref_ptr<osg_graph_viz::Edge> >::iterator it;
+    for(it=edgeList.begin(); it!=edgeList.end(); ++it) {
+      (*it)->setNodeMask(mask);
+    }
+  }
+
+  void View::setFarZoom(bool v) {
+    farZoom = v;
+    unsigned int mask = v ? 0 : ~0u;
+    flatBatch->setNodeMask(v ? ~0u : 0);
+    if(bodyBatch.valid()) {
+      bodyBatch->setEnabled(!v);
+    }
+    if(bundledEdges) {
+      applyBundles();
+    }
+    if(viewportCulling) {
+      // culled elements are updated once they become visible
+      std::unordered_set<Node*>::iterator it;
+      std::unordered_set<Edge*>::iterator it2;
+      for(it=visibleNodes.begin(); it!=visibleNodes.end(); ++it) {
+        (*it)->setNodeMask(mask);
+      }
+      for(it2=visibleEdges.begin(); it2!=visibleEdges.end(); ++it2) {
+        (*it2)->setFarZoom(straightEdges());
+      }
+      return;
+    }
+    std::list<osg::ref_ptr<osg_graph_viz::Node> >::iterator it;
+    std::list<osg::ref_ptr<osg_graph_viz::Edge> >::iterator it2;
+    for(it=nodeList.begin(); it!=nodeList.end(); ++it) {
+      (*it)->setNodeMask(mask);
+    }
+    for(it2=edgeList.begin(); it2!=edgeList.end(); ++it2) {
+      (*it2)->setFarZoom(straightEdges());
+    }
+  }
+
+  void View::setTextVisible(bool v) {
+    textVisible = v;
+    if(viewportCulling) {
+      // culled elements are updated once they become visible
+      std::unordered_set<Node*>::iterator it;
+      std::unordered_set<Edge*>::iterator it2;
+      for(it=visibleNodes.begin(); it!=visibleNodes.end(); ++it) {
+        (*it)->derenderText(v);
+      }
+      for(it2=visibleEdges.begin(); it2!=visibleEdges.end(); ++it2) {
+        (*it2)->derenderText(v);
       }
+      return;
+    }
+    std::list<osg::ref_ptr<osg_graph_viz::Node> >::iterator it;
+    std::list<osg::ref_ptr<osg_graph_viz::Edge> >::iterator it2;
+    for(it=nodeList.begin(); it!=nodeList.end(); ++it) {
+      (*it)->derenderText(v);
+    }
+    for(it2=edgeList.begin(); it2!=edgeList.end(); ++it2) {
+      (*it2)->derenderText(v);
+    }
+  }
+
+  void View::scaleView(double newScale, double x, double y) {
+    double lastMX = (mouseX*1920 - posX) / scale;
+    double lastMY = (mouseY*1080 - posY) / (scale*scaleRatio);
+    scale = newScale;
+    inScale = true;
+    // the labels are only switched when the scale leaves the band between
+    // the two thresholds, zooming inside the band touches no scene node
+    if(textVisible && scale < textHideScale) {
+      setTextVisible(false);
+    }
+    else if(!textVisible && scale > textShowScale) {
+      setTextVisible(true);
     }
 
     if(scale < 0.1) {
       scale = 0.1;
     }
+    if(!farZoom && scale < farEnterScale) {
+      setFarZoom(true);
+    }
+    else if(farZoom && scale > farLeaveScale) {
+      setFarZoom(false);
+    }
     mainScale->setMatrix(osg::Matrix::scale(scale, scale*scaleRatio, 1.));
     double newX = (x*1920 - posX) / scale;
     double newY = (y*1080 - posY) / (scale*scaleRatio);
     posX += (newX-lastMX)*scale;
     posY += (newY-lastMY)*(scale*scaleRatio);
     mainPos->setPosition(osg::Vec3(posX, posY, 0.0));
-    for(std::list<osg::ref_ptr<Edge> >::iterator it=edgeList.begin();
-        it!=edgeList.end(); ++it) {
-      (*it)->setLineWidth(scale*0.5);
+    if(viewportCulling) {
+      for(std::unordered_set<Edge*>::iterator it=visibleEdges.begin();
+          it!=visibleEdges.end(); ++it) {
+        (*it)->setLineWidth(scale*0.5);
+      }
+      for(std::unordered_set<Node*>::iterator it=visibleNodes.begin();
+          it!=visibleNodes.end(); ++it) {
+        (*it)->setLineWidth(scale*0.5);
+      }
+    }
+    else {
+      for(std::list<osg::ref_ptr<Edge> >::iterator it=edgeList.begin();
+          it!=edgeList.end(); ++it) {
+        (*it)->setLineWidth(scale*0.5);
+      }
+      for(std::list<osg::ref_ptr<osg_graph_viz::Node> >::iterator it=nodeList.begin();
+          it!=nodeList.end(); ++it) {
+        (*it)->setLineWidth(scale*0.5);
+      }
     }
-    for(std::list<osg::ref_ptr<osg_graph_viz::Node> >::iterator it=nodeList.begin();
-        it!=nodeList.end(); ++it) {
-      (*it)->setLineWidth(scale*0.5);
+    if(edgeBatch.valid()) {
+      edgeBatch->setLineWidth(scale*0.5);
     }
     if(addEdge) {
       newEdge->setLineWidth(scale*0.5);
@@ -578,11 +1468,13 @@ namespace osg_graph_viz {
           nodeToMove->setPosition2(cPosX, cPosY);
           checkHeader = true;
           //nodeToMove->getPosition(&newX, &newY);
-          ui->updateNode(nodeToMove.get());
+          notifyNode(nodeToMove.get());
+          dragNodes.insert(nodeToMove.get());
         }
         else if(selectedEdge.valid()) {
           selectedEdge->mouseMove(cPosX, cPosY);
-          ui->updateEdge(selectedEdge.get());
+          notifyEdge(selectedEdge.get());
+          dragEdges.insert(selectedEdge.get());
         }
         if(checkHeader) {
           if(addToGroupNode.valid()) {
@@ -592,9 +1484,12 @@ namespace osg_graph_viz {
             }
           }
           if(!addToGroupNode.valid()) {
-            for(it=nodeList.begin(); it!=nodeList.end(); ++it) {
-              if(!(*it)->isSelected() && (*it)->checkMouseHeaderPress(cPosX, cPosY)) {
-                addToGroupNode = *it;
+            std::vector<Node*> candidates;
+            getNodesAt(cPosX, cPosY, &candidates);
+            std::vector<Node*>::iterator nt;
+            for(nt=candidates.begin(); nt!=candidates.end(); ++nt) {
+              if(!(*nt)->isSelected() && (*nt)->checkMouseHeaderPress(cPosX, cPosY)) {
+                addToGroupNode = *nt;
                 addToGroupNode->setSelected(true);
                 break;
               }
@@ -631,6 +1526,8 @@ namespace osg_graph_viz {
     double cPosX = (x*1920 - posX) / scale;
     double cPosY = (y*1080 - posY) / (scale*scaleRatio);
     mouseMoved = false;
+    // the edges of dragged nodes are updated once per frame
+    deferEdges = true;
     sprintf(da, "mouse [%g, %g] --- pressed %d", x, y, button);
     infoText->setText(da);
     mouseMask = button;
@@ -655,14 +1552,17 @@ namespace osg_graph_viz {
         int toIdx;
         bool found = false;
         addEdge = false;
-        for(it=nodeList.begin(); it!=nodeList.end(); ++it) {
-          if((*it)->checkMouseInPortPress(cPosX, cPosY,
+        std::vector<Node*> candidates;
+        getNodesAt(cPosX, cPosY, &candidates);
+        std::vector<Node*>::iterator nt;
+        for(nt=candidates.begin(); nt!=candidates.end(); ++nt) {
+          if((*nt)->checkMouseInPortPress(cPosX, cPosY,
                                           &vX, &vY, &toIdx)) {
             //fprintf(stderr, "mousePress %g/%g\n", vX, vY);
-            ConfigMap info = newEdgeFromNode->getOutPortEdgeInfo(newEdgeFromIdx);
-            if((*it)->isCompatible(info, toIdx)) {
+            if((*nt)->isCompatible(newEdgeFromNode.get(), newEdgeFromIdx,
+                                   toIdx)) {
               newEdge->updateEndPos(osg::Vec3(vX, vY, 0.0));
-              handleNewEdge(*it, toIdx);
+              handleNewEdge(*nt, toIdx);
               found = true;
             }
             break;
@@ -711,8 +1611,10 @@ namespace osg_graph_viz {
 
         if(modKey) {
           { // check if we click on an edge
-            std::list<osg::ref_ptr<osg_graph_viz::Edge> >::iterator jt;
-            for(jt=edgeList.begin(); jt!=edgeList.end(); ++jt) {
+            std::vector<Edge*> candidates;
+            getEdgesAt(cPosX, cPosY, &candidates);
+            std::vector<Edge*>::iterator jt;
+            for(jt=candidates.begin(); jt!=candidates.end(); ++jt) {
               if((*jt)->checkMousePress(cPosX, cPosY)) {
                 selectedEdge = (*jt);
                 if(selectedEdge.get() != oldEdge && ui) {
@@ -730,21 +1632,22 @@ namespace osg_graph_viz {
           }
           if(!selectedEdge.valid()) {
             // check if we click on a node
-            for(it=nodeList.begin(); it!=nodeList.end(); ++it) {
-              if((*it)->checkMousePress(cPosX, cPosY)) {
-                selectedNode = *it;
+            std::vector<Node*> candidates;
+            getNodesAt(cPosX, cPosY, &candidates);
+            std::vector<Node*>::iterator nt;
+            for(nt=candidates.begin(); nt!=candidates.end(); ++nt) {
+              if((*nt)->checkMousePress(cPosX, cPosY)) {
+                selectedNode = *nt;
                 if(!selectedNode->isSelected()) {
                   dontDeselectOnRelease = true;
                 }
                 selectedNode->setSelected(true);
                 if(selectedNode.get() != oldNode && ui) {
-                  ui->nodeSelected(*it);
+                  ui->nodeSelected(*nt);
                 }
-                (*it)->savePosOffset(cPosX, cPosY);
-                nodeToMove = *it;
-                nodeList.erase(it);
-                nodeList.push_front(selectedNode.get());
-                selectedNode.get()->setRenderOrder(++renderBin);
+                (*nt)->savePosOffset(cPosX, cPosY);
+                nodeToMove = *nt;
+                raiseNode(selectedNode.get());
                 break;
               }
             }
@@ -767,8 +1670,10 @@ namespace osg_graph_viz {
           bool clearSelection_ = true;
 
           {
-            std::list<osg::ref_ptr<osg_graph_viz::Edge> >::iterator it;
-            for(it=edgeList.begin(); it!=edgeList.end(); ++it) {
+            std::vector<Edge*> candidates;
+            getEdgesAt(cPosX, cPosY, &candidates);
+            std::vector<Edge*>::iterator it;
+            for(it=candidates.begin(); it!=candidates.end(); ++it) {
               if((*it)->checkMousePress(cPosX, cPosY)) {
                 selectedEdge = (*it);
                 if(selectedEdge.get() != oldEdge && ui) {
@@ -786,20 +1691,23 @@ namespace osg_graph_viz {
           }
 
           if(!selectedEdge.valid()) {
-            for(it=nodeList.begin(); it!=nodeList.end(); ++it) {
-              if((*it)->checkMousePress(cPosX, cPosY) ||
-                 (*it)->checkMouseOutPortPress(cPosX, cPosY, &vX, &vY, &newEdgeFromIdx)) {
-                selectedNode = *it;
+            std::vector<Node*> candidates;
+            getNodesAt(cPosX, cPosY, &candidates);
+            std::vector<Node*>::iterator nt;
+            for(nt=candidates.begin(); nt!=candidates.end(); ++nt) {
+              if((*nt)->checkMousePress(cPosX, cPosY) ||
+                 (*nt)->checkMouseOutPortPress(cPosX, cPosY, &vX, &vY, &newEdgeFromIdx)) {
+                selectedNode = *nt;
                 if(selectedNode->isSelected()) {
                   clearSelection_ = false;
                 }
                 selectedNode->setSelected(true);
                 if(selectedNode.get() != oldNode && ui) {
-                  ui->nodeSelected(*it);
+                  ui->nodeSelected(*nt);
                 }
-                if((*it)->checkMouseOutPortPress(cPosX, cPosY,
+                if((*nt)->checkMouseOutPortPress(cPosX, cPosY,
                                                  &vX, &vY, &newEdgeFromIdx)) {
-                  newEdgeFromNode = *it;
+                  newEdgeFromNode = *nt;
                   osg::Vec3 outV = newEdgeFromNode->getOutPortPos(newEdgeFromIdx);
                   ConfigMap info;
                   info = newEdgeFromNode->getOutPortEdgeInfo(newEdgeFromIdx);
@@ -846,17 +1754,16 @@ namespace osg_graph_viz {
                   nodeToMove = 0;
                   newEdge->setLineWidth(scale*0.5);
                   for(jt=nodeList.begin(); jt!=nodeList.end(); ++jt) {
-                    (*jt)->markInputsByEdgeInfo(info);
+                    (*jt)->markCompatibleInputs(newEdgeFromNode.get(),
+                                                newEdgeFromIdx);
                   }
                 }
                 else {
                   //if((*it)->checkMouseHeaderPress(cPosX, cPosY)) {
-                  (*it)->savePosOffset(cPosX, cPosY);
-                  nodeToMove = *it;
+                  (*nt)->savePosOffset(cPosX, cPosY);
+                  nodeToMove = *nt;
                 }
-                nodeList.erase(it);
-                nodeList.push_front(selectedNode.get());
-                selectedNode.get()->setRenderOrder(++renderBin);
+                raiseNode(selectedNode.get());
                 break;
               }
             }
@@ -894,6 +1801,16 @@ namespace osg_graph_viz {
     double cPosX = (x*1920 - posX) / scale;
     double cPosY = (y*1080 - posY) / (scale*scaleRatio);
 
+    deferEdges = false;
+    flushEdgeUpdates();
+    if(!dragNodes.empty() || !dragEdges.empty()) {
+      flushChanges();
+      std::vector<Node*> nodes(dragNodes.begin(), dragNodes.end());
+      std::vector<Edge*> edges(dragEdges.begin(), dragEdges.end());
+      dragNodes.clear();
+      dragEdges.clear();
+      if(ui) ui->dragFinished(nodes, edges);
+    }
     if(inScale) {
       inScale = false;
       for(std::list<osg::ref_ptr<osg_graph_viz::Node> >::iterator it=nodeList.begin();
@@ -909,8 +1826,10 @@ namespace osg_graph_viz {
       osg_graph_viz::Node *n = NULL;
       int inPort = -1, outPort = -1;
       {
-        std::list<osg::ref_ptr<osg_graph_viz::Edge> >::iterator it;
-        for(it=edgeList.begin(); it!=edgeList.end(); ++it) {
+        std::vector<Edge*> candidates;
+        getEdgesAt(cPosX, cPosY, &candidates);
+        std::vector<Edge*>::iterator it;
+        for(it=candidates.begin(); it!=candidates.end(); ++it) {
           if((*it)->checkMousePress(cPosX, cPosY)) {
             e = (*it);
             break;
@@ -919,8 +1838,10 @@ namespace osg_graph_viz {
       }
       if(!e) {
         double vX, vY;
-        std::list<osg::ref_ptr<osg_graph_viz::Node> >::iterator it;
-        for(it=nodeList.begin(); it!=nodeList.end(); ++it) {
+        std::vector<Node*> candidates;
+        getNodesAt(cPosX, cPosY, &candidates);
+        std::vector<Node*>::iterator it;
+        for(it=candidates.begin(); it!=candidates.end(); ++it) {
           int idx;
           if((*it)->checkMouseInPortPress(cPosX, cPosY,
                                           &vX, &vY, &idx)) {
@@ -949,21 +1870,24 @@ namespace osg_graph_viz {
     int toIdx;
     double vX, vY;
     if(addEdge && !(button & 1) && (mouseMask & 1)) {
-      std::list<osg::ref_ptr<osg_graph_viz::Node> >::iterator it;
-      for(it=nodeList.begin(); it!=nodeList.end(); ++it) {
-        if((*it)->checkMouseInPortPress(cPosX, cPosY,
+      std::vector<Node*> candidates;
+      getNodesAt(cPosX, cPosY, &candidates);
+      std::vector<Node*>::iterator nt;
+      for(nt=candidates.begin(); nt!=candidates.end(); ++nt) {
+        if((*nt)->checkMouseInPortPress(cPosX, cPosY,
                                         &vX, &vY, &toIdx)) {
-          ConfigMap info = newEdgeFromNode->getOutPortEdgeInfo(newEdgeFromIdx);
-          if((*it)->isCompatible(info, toIdx)) {
+          if((*nt)->isCompatible(newEdgeFromNode.get(), newEdgeFromIdx,
+                                 toIdx)) {
             //fprintf(stderr, "mouseRelease %g/%g\n", vX, vY);
             newEdge->updateEndPos(osg::Vec3(vX, vY, 0.0));
-            handleNewEdge(*it, toIdx);
+            handleNewEdge(*nt, toIdx);
           }
           else {
             content->removeChild(newEdge.get());
           }
           addEdge = false;
           newEdge = NULL;
+          std::list<osg::ref_ptr<osg_graph_viz::Node> >::iterator it;
           for(it=nodeList.begin(); it!=nodeList.end(); ++it) {
             (*it)->unmarkInputs();
           }
@@ -1035,7 +1959,7 @@ namespace osg_graph_viz {
     newEdge->fromIdx = newEdgeFromIdx;
     newEdge->toIdx = toIdx;
     if(fromFoldInfo.size() <= 1 && toFoldInfo.size() <= 1) {
-      edgeList.push_front(newEdge.get());
+      addEdgeToList(newEdge.get());
       newEdgeFromNode->addOutputEdge(newEdgeFromIdx, newEdge.get());
       toNode->addInputEdge(toIdx, newEdge.get());
       ui->newEdge(newEdge.get(), newEdgeFromNode, newEdgeFromIdx,
@@ -1056,7 +1980,7 @@ namespace osg_graph_viz {
             s2 = it2->second.substr(p2+1);
             if(s1 == s2) {
               osg_graph_viz::Edge *edge = new osg_graph_viz::Edge(newEdge->getMap(), this, mergeIconSize);
-              edgeList.push_front(edge);
+              addEdgeToList(edge);
               content->addChild(edge);
               edge->getOrCreateStateSet()->setRenderBinDetails(renderBin,
                                                                "RenderBin");
@@ -1085,60 +2009,174 @@ namespace osg_graph_viz {
   }
 
   void View::deleteKey() {
-    for(std::list<osg::ref_ptr<osg_graph_viz::Edge> >::iterator it = edgeList.begin(); it != edgeList.end();){
-      if((*it)->isSelected()){
+    beginUpdate();
+    std::vector<Edge*> edges;
+    std::list<osg::ref_ptr<osg_graph_viz::Edge> >::iterator it;
+    for(it=edgeList.begin(); it!=edgeList.end(); ++it) {
+      if((*it)->isSelected()) {
         (*it)->setSelected(false);
-        it = removeEdge(*it);
-        selectedEdge = NULL;
-      }else{
-        ++it;
+        edges.push_back(it->get());
       }
     }
+    removeEdges(edges);
+    selectedEdge = NULL;
     selectedEdges.clear();
 
-
-    for(std::list<osg::ref_ptr<osg_graph_viz::Node> >::iterator it = nodeList.begin(); it != nodeList.end();){
-      if((*it)->isSelected()){
-        (*it)->setSelected(false);
-        it = removeNode(*it);
-        selectedNode = NULL;
-      }else{
-        ++it;
+    std::vector<Node*> nodes;
+    std::list<osg::ref_ptr<osg_graph_viz::Node> >::iterator nt;
+    for(nt=nodeList.begin(); nt!=nodeList.end(); ++nt) {
+      if((*nt)->isSelected()) {
+        (*nt)->setSelected(false);
+        nodes.push_back(nt->get());
       }
     }
+    removeNodes(nodes);
+    selectedNode = NULL;
     selectedNodes.clear();
+    endUpdate();
   }
 
-  std::list<osg::ref_ptr<osg_graph_viz::Edge> >::iterator View::removeEdge(osg_graph_viz::Edge *edge) {
-    std::list<osg::ref_ptr<osg_graph_viz::Edge> >::iterator it;
-    for(it=edgeList.begin(); it!=edgeList.end(); ++it) {
-      if(it->get() == edge) {
-        break;
+  void View::removeEdgeFromList(Edge *edge) {
+    edgeIndex.remove(edge);
+    visibleEdges.erase(edge);
+    boundsEdges.erase(edge);
+    changedEdges.erase(edge);
+    dragEdges.erase(edge);
+    if(bundler.valid()) {
+      bundler->remove(edge);
+    }
+    edge->setNodeMask(~0u);
+    edge->setEdgeBatch(NULL);
+    if(edge->inEdgeList) {
+      edge->inEdgeList = false;
+      edgeList.erase(edge->listHandle);
+    }
+  }
+
+  void View::removeNodeFromList(Node *node) {
+    nodeIndex.remove(node);
+    visibleNodes.erase(node);
+    edgeUpdateNodes.erase(node);
+    layoutNodes.erase(node);
+    boundsNodes.erase(node);
+    changedNodes.erase(node);
+    dragNodes.erase(node);
+    node->setNodeMask(~0u);
+    if(bodyBatch.valid()) {
+      bodyBatch->remove(node);
+    }
+    flatBatch->remove(node);
+    if(node->inNodeList) {
+      eraseNodeName(node->getName(), node);
+      node->inNodeList = false;
+      nodeList.erase(node->listHandle);
+    }
+  }
+
+  void View::removeChildrenFromContent(const std::unordered_set<osg::Node*> &nodes) {
+    if(nodes.empty()) return;
+    if(nodes.size() <= 8) {
+      std::unordered_set<osg::Node*>::const_iterator it;
+      for(it=nodes.begin(); it!=nodes.end(); ++it) {
+        content->removeChild(*it);
+      }
+      return;
+    }
+    // removeChild searches the children linearly, rebuild the list instead
+    std::vector<osg::ref_ptr<osg::Node> > keep;
+    keep.reserve(content->getNumChildren());
+    for(unsigned int i=0; i<content->getNumChildren(); ++i) {
+      if(nodes.find(content->getChild(i)) == nodes.end()) {
+        keep.push_back(content->getChild(i));
       }
     }
+    if(keep.size() == content->getNumChildren()) return;
+    content->removeChildren(0, content->getNumChildren());
+    for(size_t i=0; i<keep.size(); ++i) {
+      content->addChild(keep[i].get());
+    }
+  }
+
+  std::list<osg::ref_ptr<osg_graph_viz::Edge> >::iterator View::removeEdge(osg_graph_viz::Edge *edge) {
+    std::list<osg::ref_ptr<osg_graph_viz::Edge> >::iterator it = edgeList.end();
+    if(edge->inEdgeList) {
+      it = edge->listHandle;
+      ++it;
+    }
     if(ui->removeEdge(edge)) {
-      it = edgeList.erase(it);
+      osg::ref_ptr<Edge> keep = edge;
+      removeEdgeFromList(edge);
       edge->removeFromNodes();
       content->removeChild(edge);
-      return it;
     }
-    return ++it;
+    return it;
   }
 
   std::list<osg::ref_ptr<osg_graph_viz::Node> >::iterator View::removeNode(osg_graph_viz::Node *node) {
-    std::list<osg::ref_ptr<osg_graph_viz::Node> >::iterator it;
-    for(it=nodeList.begin(); it!=nodeList.end(); ++it) {
-      if(it->get() == node) {
-        break;
-      }
+    std::list<osg::ref_ptr<osg_graph_viz::Node> >::iterator it = nodeList.end();
+    if(node->inNodeList) {
+      it = node->listHandle;
+      ++it;
     }
     if(ui->removeNode(node)) {
-      it = nodeList.erase(it);
+      osg::ref_ptr<Node> keep = node;
+      removeNodeFromList(node);
       node->removeEdges();
       content->removeChild(node);
-      return it;
     }
-    return ++it;
+    return it;
+  }
+
+  void View::removeEdges(const std::vector<osg_graph_viz::Edge*> &edges) {
+    std::vector<osg::ref_ptr<osg::Node> > removed;
+    std::unordered_set<osg::Node*> detach;
+    detachEdges(edges, &detach, &removed);
+    removeChildrenFromContent(detach);
+  }
+
+  void View::detachEdges(const std::vector<osg_graph_viz::Edge*> &edges,
+                         std::unordered_set<osg::Node*> *detach,
+                         std::vector<osg::ref_ptr<osg::Node> > *removed) {
+    for(size_t i=0; i<edges.size(); ++i) {
+      // edges that are not in the list still have to leave their ports
+      if(detach->find(edges[i]) != detach->end()) continue;
+      if(ui->removeEdge(edges[i])) {
+        removed->push_back(edges[i]);
+        removeEdgeFromList(edges[i]);
+        edges[i]->removeFromNodes();
+        detach->insert(edges[i]);
+      }
+    }
+  }
+
+  void View::removeNodes(const std::vector<osg_graph_viz::Node*> &nodes) {
+    std::vector<osg::ref_ptr<osg::Node> > removed;
+    std::vector<Edge*> edges;
+    std::unordered_set<Edge*> seen;
+    std::unordered_set<osg::Node*> detach;
+    std::list<osg::ref_ptr<Edge> >::iterator et;
+    for(size_t i=0; i<nodes.size(); ++i) {
+      if(!nodes[i]->inNodeList) continue;
+      if(!ui->removeNode(nodes[i])) continue;
+      removed.push_back(nodes[i]);
+      removeNodeFromList(nodes[i]);
+      detach.insert(nodes[i]);
+      std::vector<Port*> *ports[2] = {&nodes[i]->inPorts,
+                                     &nodes[i]->outPorts};
+      for(int k=0; k<2; ++k) {
+        for(size_t p=0; p<ports[k]->size(); ++p) {
+          std::list<osg::ref_ptr<Edge> > &pEdges = (*ports[k])[p]->edges;
+          for(et=pEdges.begin(); et!=pEdges.end(); ++et) {
+            if(seen.insert(et->get()).second) {
+              edges.push_back(et->get());
+            }
+          }
+        }
+      }
+    }
+    // the nodes and their edges leave the scene in one pass
+    detachEdges(edges, &detach, &removed);
+    removeChildrenFromContent(detach);
   }
 
   void View::updateMap(const ConfigMap &map) {
@@ -1166,7 +2204,7 @@ namespace osg_graph_viz {
     }
     if(selectedEdge.valid()) {
       selectedEdge->decoupleEdge();
-      ui->updateEdge(selectedEdge.get());
+      notifyEdge(selectedEdge.get());
     }
   }
 
@@ -1187,9 +2225,11 @@ namespace osg_graph_viz {
   void View::repositionEdges() {
     std::list<osg::ref_ptr<osg_graph_viz::Edge> >::iterator it;
 
+    beginUpdate();
     for(it=edgeList.begin(); it!=edgeList.end(); ++it) {
       (*it)->reposition();
     }
+    endUpdate();
   }
 
   void View::decoupleLongEdges() {
@@ -1208,7 +2248,6 @@ namespace osg_graph_viz {
     double xNodePos=0, yNodePos=0;
     double xUpper=0, xLower=0, yUpper=0, yLower=0;
     double xStartCalc, xEndCalc, yStartCalc, yEndCalc;
-    std::list<osg::ref_ptr<osg_graph_viz::Node> >::iterator it;
 
     xStartCalc = xStartSelection;
     yStartCalc = yStartSelection;
@@ -1242,15 +2281,42 @@ namespace osg_graph_viz {
     /*std::cout << "[SELECTION] xLower: " << xLower <<", xUpper: " << xUpper << "| yLower: " << yLower <<", yUpper: "
       <<yUpper<<std::endl;*/
 
-    for(it=nodeList.begin(); it!=nodeList.end(); ++it) {
-      (*it)->getPosition(&xNodePos, &yNodePos);
-      /*std::cout << "[SELECTION] NodePos x: " << xNodePos << ", NodePos y: " << yNodePos<<std::endl;*/
-      if((xNodePos>= xLower && xNodePos<= xUpper) && (yNodePos>= yLower && yNodePos <= yUpper)){
+    // the anchor of a node is part of its rectangle, so all modes only
+    // have to check the nodes intersecting the selection
+    std::vector<Node*> nodes;
+    nodeIndex.queryRect(xLower, xUpper, yLower, yUpper, &nodes);
+    for(std::vector<Node*>::iterator it=nodes.begin(); it!=nodes.end(); ++it) {
+      bool select = false;
+      if(selectionMode == SELECT_BY_ANCHOR) {
+        (*it)->getPosition(&xNodePos, &yNodePos);
+        /*std::cout << "[SELECTION] NodePos x: " << xNodePos << ", NodePos y: " << yNodePos<<std::endl;*/
+        select = ((xNodePos>= xLower && xNodePos<= xUpper) &&
+                  (yNodePos>= yLower && yNodePos <= yUpper));
+      }
+      else if(selectionMode == SELECT_BY_CONTAINMENT) {
+        double x1, x2, y1, y2;
+        (*it)->getWorldRectangle(&x1, &x2, &y1, &y2);
+        select = (x1 >= xLower && x2 <= xUpper && y1 >= yLower && y2 <= yUpper);
+      }
+      else {
+        select = true;
+      }
+      if(select) {
         (*it)->setSelected(true);
         //(*it)->confMapToYml((*it));
         selectedNodes.push_back((*it));
       }
     }
+    if(selectionMode == SELECT_BY_ANCHOR) return;
+
+    std::vector<Edge*> edges;
+    edgeIndex.queryRect(xLower, xUpper, yLower, yUpper, &edges);
+    for(std::vector<Edge*>::iterator it=edges.begin(); it!=edges.end(); ++it) {
+      if((*it)->isInsideRectangle(xLower, xUpper, yLower, yUpper)) {
+        (*it)->setSelected(true);
+        selectedEdges.push_back(*it);
+      }
+    }
   }
 
 
@@ -1278,7 +2344,7 @@ namespace osg_graph_viz {
     v->at(2) = osg::Vec3(x+width, y+height, 0);
     v->at(3) = osg::Vec3(x, y+height, 0);
     v->at(4) = osg::Vec3(x, y, 0);
-    selectionGeom->dirtyDisplayList();
+    selectionVertices->dirty();
     selectionGeom->dirtyBound();
   }
 
@@ -1573,9 +2639,11 @@ namespace osg_graph_viz {
 
   void View::setEdgesSmooth(bool v) {
     std::list<osg::ref_ptr<osg_graph_viz::Edge> >::iterator it;
+    beginUpdate();
     for(it=edgeList.begin(); it!=edgeList.end(); ++it) {
       (*it)->setSmooth(v);
     }
+    endUpdate();
   }
 
   void View::duplicateSelection() {
@@ -1586,6 +2654,7 @@ namespace osg_graph_viz {
     std::vector<osg::ref_ptr<osg_graph_viz::Edge> >::iterator outEdgesIt;
     osg_graph_viz::Node *newNode;
     std::map<std::string, std::string> nameMapping;
+    beginUpdate();
     for(std::list<osg::ref_ptr<osg_graph_viz::Node> >::iterator it = nodeList.begin(); it != nodeList.end(); ++it){
       if((*it)->isSelected()){
         ConfigMap map = (*it)->getMap();
@@ -1626,6 +2695,7 @@ namespace osg_graph_viz {
       (*it)->setSelected(true);
     }
     newSelection.swap(selectedNodes);
+    endUpdate();
   }
 
   void View::copySelection() {
@@ -1670,6 +2740,7 @@ namespace osg_graph_viz {
     if(!bufferMap.hasKey("nodes")) {
       return;
     }
+    beginUpdate();
 
     int paste_offset_x = 0;
     int paste_offset_y = 0;
@@ -1716,6 +2787,7 @@ namespace osg_graph_viz {
       (*it)->setSelected(true);
     }
     newSelection.swap(selectedNodes);
+    endUpdate();
   }
   void View::undoPreviousAction() {
      ui->undo();
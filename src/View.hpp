@@ -10,15 +10,24 @@
 #include "Node.hpp"
 #include "Edge.hpp"
 #include "UpdateInterface.hpp"
+#include "SpatialGrid.hpp"
+#include "RoundBodyBatch.hpp"
+#include "EdgeBatch.hpp"
+#include "FlatNodeBatch.hpp"
+#include "EdgeBundler.hpp"
 
 #include <osg/MatrixTransform>
 #include <osg/Geometry>
 #include <osgText/Text>
+#include <osgText/Font>
 #include <osg/PositionAttitudeTransform>
 #include <osg/MatrixTransform>
 #include <osgGA/GUIEventHandler>
 #include <osg/Camera>
 #include <list>
+#include <unordered_map>
+#include <unordered_set>
+#include <mutex>
 
 #include <mars/osg_text/Text.h>
 
@@ -36,6 +45,12 @@ namespace osg_graph_viz {
     SMOOTH_LINE_MODE,
   };
 
+  enum SelectionMode {
+    SELECT_BY_ANCHOR,        // node position inside the rubber band
+    SELECT_BY_CONTAINMENT,   // whole node or edge inside the rubber band
+    SELECT_BY_INTERSECTION,  // node touched by the rubber band
+  };
+
   class Tab {
   public:
     osg::ref_ptr<osg_text::Text> label;
@@ -52,11 +67,25 @@ namespace osg_graph_viz {
     osg_graph_viz::Node* createNode(const NodeInfo &info);
     osg_graph_viz::Edge* createEdge(const configmaps::ConfigMap &info,
                                     int idx1, int idx2);
+    // builds the "nodes" and "edges" of the map detached from the scene and
+    // attaches them at once, the edges reference the nodes and ports by name
+    void loadGraph(const configmaps::ConfigMap &graph);
+    // number of threads building the nodes and edges in loadGraph(), 0 uses
+    // one thread per core
+    void setLoadThreads(unsigned int n) {loadThreads = n;}
+    // queues the graph, update() builds the nodes closest to the visible
+    // area first and spends at most the load budget per frame on it
+    void queueGraph(const configmaps::ConfigMap &graph);
+    void setLoadBudget(double ms) {loadBudget = ms;}
+    bool isLoading() {return loadNext < loadNodes.size() || !loadReady.empty();}
     double mergeIconSize, portFontSize, headerFontSize, portScale;
 
     osg::Group* getScene() {return scene.get();}
     std::list<osg::ref_ptr<osg_graph_viz::Edge> >::iterator removeEdge(osg_graph_viz::Edge*);
     std::list<osg::ref_ptr<osg_graph_viz::Node> >::iterator removeNode(osg_graph_viz::Node*);
+    // remove several elements and detach them from the scene in one pass
+    void removeEdges(const std::vector<osg_graph_viz::Edge*> &edges);
+    void removeNodes(const std::vector<osg_graph_viz::Node*> &nodes);
 
     void update(void);
 
@@ -66,14 +95,25 @@ namespace osg_graph_viz {
     void getPosition(double *x, double *y);
     void deleteKey();
     void scaleView(double newScale, double x=0, double y=0);
+    // the labels are hidden below the first and shown again above the
+    // second scale
+    void setTextLodThresholds(double hide, double show);
+    // below the first scale the nodes are drawn as flat quads and the edges
+    // as straight lines until the scale rises above the second one
+    void setFarZoomThresholds(double enter, double leave);
     void getViewScale(double *scale);
     void setViewPos(double x=0, double y=0);
     void getViewPos(double *x, double *y);
     osg::Texture2D *loadTexture(const std::string &file);
+    // fonts are shared by the glyph atlases of all text batches
+    osgText::Font *loadFont(const std::string &file);
+    // loads the material from the shader folder once and shares its state
+    osg::StateSet *loadMaterial(const std::string &name);
 
     void setUpdateInterface(UpdateInterface *ui) {this->ui = ui;}
     void updateMap(const configmaps::ConfigMap &map);
     void setLineMode(LineMode mode) {lineMode = mode;}
+    void setSelectionMode(SelectionMode mode) {selectionMode = mode;}
     void setModKey(bool v);
     void setScaleRatio(double value);
     void decoupleSelected();    
@@ -82,7 +122,23 @@ namespace osg_graph_viz {
     void repositionEdges();
     void decoupleLongEdges();
     std::list<osg::ref_ptr<osg_graph_viz::Node> > getSelectedNodes();
-    void setResourcesPath(std::string path) {resourcesPath = path;}
+    void setResourcesPath(std::string path);
+    // draws the bodies of the round nodes created afterwards with one
+    // instanced draw call, should be set before the graph is loaded
+    void setInstancedBodies(bool v) {instancedBodies = v;}
+    RoundBodyBatch* getRoundBodyBatch();
+    // draws the polylines of the edges added afterwards from shared arrays
+    void setBatchedEdges(bool v) {batchedEdges = v;}
+    // replaces the edges by bundles between the top level nodes while the
+    // view is zoomed out
+    void setBundledEdges(bool v);
+    // draws the labels of the nodes created afterwards with one text batch
+    // per node instead of a drawable per label
+    void setBatchedText(bool v) {batchedText = v;}
+    bool getBatchedText() {return batchedText;}
+    // masks the nodes and edges outside of the visible area and skips them
+    // in the per zoom updates, the visible set is updated in update()
+    void setViewportCulling(bool v);
     std::string getResourcesPath() {return resourcesPath;}
 
     // implements osgGA::GUIEventHandler::handle
@@ -93,6 +149,28 @@ namespace osg_graph_viz {
     void saveTab(configmaps::ConfigMap &map);
     void clearSelection(bool whole);
     osg::ref_ptr<Node> getNodeByName(const std::string &name);
+    // called by the nodes after their map was replaced
+    void updateNodeName(const std::string &oldName, Node *node);
+    // called by the nodes whenever their position or size changes
+    void updateNodeBounds(Node *node);
+    // called by the nodes whenever their body color or visibility changes
+    void updateFlatNode(Node *node);
+    // returns the nodes under the given world position, front-most first
+    void getNodesAt(double x, double y, std::vector<Node*> *nodes);
+    // called by the edges whenever their geometry changes
+    void updateEdgeBounds(Edge *edge);
+    // called by the edges whenever their start or end node changes
+    void updateEdgeBundle(Edge *edge);
+    // returns true if the edges of the node are updated with the next frame
+    bool deferEdgeUpdate(Node *node);
+    // returns true if the ports of the node are laid out in endUpdate()
+    bool deferLayout(Node *node);
+    // can be nested, until the outermost endUpdate() the edge updates, port
+    // layouts and picking bounds are collected and then done once per element
+    void beginUpdate();
+    void endUpdate();
+    // returns the edges close to the given world position, newest first
+    void getEdgesAt(double x, double y, std::vector<Edge*> *edges);
     void removeNodeFromView(osg::ref_ptr<osg::Node> node);
     void addNodeToView(osg::ref_ptr<osg::Node> node);
     bool groupNodes(const std::string &parent, const std::string &child);
@@ -122,6 +200,7 @@ namespace osg_graph_viz {
   private:
     std::map<std::string, int> filterMap;
     LineMode lineMode;
+    SelectionMode selectionMode;
     int numXTicks, numYTicks;
     float xTicksDiff, yTicksDiff;
     double windowHeight, windowWidth;
@@ -138,6 +217,12 @@ namespace osg_graph_viz {
 
     std::list<osg::ref_ptr<osg_graph_viz::Node> > nodeList;
     std::list<osg::ref_ptr<osg_graph_viz::Edge> > edgeList;
+    SpatialGrid<osg_graph_viz::Node*> nodeIndex;
+    SegmentBVH edgeIndex;
+    // names can be shared for a while, e.g. by pasted nodes before they
+    // are renamed, the front-most node of a name is the one found
+    std::unordered_multimap<std::string, osg_graph_viz::Node*> nameIndex;
+    unsigned long pickCounter;
 
     int mouseMask;
     double mouseX, mouseY;
@@ -152,6 +237,10 @@ namespace osg_graph_viz {
     bool modKey, dontDeselectOnRelease;
     bool roundNodes, mouseMoved;
     bool inScale;
+    bool textVisible;
+    double textHideScale, textShowScale;
+    bool farZoom;
+    double farEnterScale, farLeaveScale;
     static unsigned long labelID;
     static configmaps::ConfigMap bufferMap;
 
@@ -166,12 +255,80 @@ namespace osg_graph_viz {
     osg::ref_ptr<osg_graph_viz::Node> nodeToMove, addToGroupNode;
 
     std::map<std::string, osg::ref_ptr<osg::Texture2D> > texMap;
+    std::map<std::string, osg::ref_ptr<osg::StateSet> > materialMap;
+    osg::ref_ptr<RoundBodyBatch> bodyBatch;
+    bool instancedBodies;
+    osg::ref_ptr<EdgeBatch> edgeBatch;
+    osg::ref_ptr<FlatNodeBatch> flatBatch;
+    osg::ref_ptr<EdgeBundler> bundler;
+    bool bundledEdges;
+    bool deferEdges;
+    std::unordered_set<osg_graph_viz::Node*> edgeUpdateNodes;
+    bool batchedEdges;
+    std::map<std::string, osg::ref_ptr<osgText::Font> > fontMap;
+    // guards the shared textures, materials, fonts and the body batch
+    std::mutex resourceMutex;
+    unsigned int loadThreads;
+    struct QueuedEdge {
+      configmaps::ConfigMap map;
+      // number of end nodes that are not built yet
+      int missing;
+    };
+    std::vector<NodeInfo> loadNodes;
+    std::vector<QueuedEdge> loadEdges;
+    std::unordered_map<std::string, std::vector<size_t> > loadWaiting;
+    std::vector<size_t> loadReady;
+    size_t loadNext, loadDone, loadTotal;
+    double loadBudget;
+    int updateDepth;
+    std::unordered_set<osg_graph_viz::Node*> layoutNodes, boundsNodes, changedNodes;
+    std::unordered_set<osg_graph_viz::Edge*> boundsEdges, changedEdges;
+    std::unordered_set<osg_graph_viz::Node*> dragNodes;
+    std::unordered_set<osg_graph_viz::Edge*> dragEdges;
+    bool batchedText;
+    bool viewportCulling, cullDirty;
+    double cullPosX, cullPosY, cullScale, cullScaleRatio;
+    std::unordered_set<osg_graph_viz::Node*> visibleNodes;
+    std::unordered_set<osg_graph_viz::Edge*> visibleEdges;
     std::string resourcesPath;
     std::map<std::string, Tab*> tabMap;
     Tab *currentTab;
     UpdateInterface *ui;
 
     void handleNewEdge(osg::ref_ptr<osg_graph_viz::Node> toNode, int toIdx);
+    // creates the node without touching the lists of the view, can be
+    // called from the load threads
+    Node* constructNode(const NodeInfo &info);
+    void registerNode(Node *node);
+    void raiseNode(Node *node);
+    Node* findNodeByName(const std::string &name);
+    void eraseNodeName(const std::string &name, Node *node);
+    void setTextVisible(bool v);
+    void setFarZoom(bool v);
+    bool showBundles() {return bundledEdges && farZoom;}
+    bool straightEdges() {return farZoom && !bundledEdges;}
+    void applyBundles();
+    void flushEdgeUpdates();
+    // collects the changes for ui->nodesChanged/edgesChanged
+    void notifyNode(Node *node);
+    void notifyEdge(Edge *edge);
+    // delivers the collected changes, at most once per frame
+    void flushChanges();
+    // builds queued nodes and edges until the load budget is used up
+    void loadStep();
+    void syncNewNode(Node *node);
+    void getVisibleRect(double *x1, double *x2, double *y1, double *y2);
+    void updateCulling();
+    void preloadMaterials();
+    void addEdgeToList(Edge *edge);
+    void removeEdgeFromList(Edge *edge);
+    void removeNodeFromList(Node *node);
+    // detaches the edges from their ports and collects them for
+    // removeChildrenFromContent()
+    void detachEdges(const std::vector<osg_graph_viz::Edge*> &edges,
+                     std::unordered_set<osg::Node*> *detach,
+                     std::vector<osg::ref_ptr<osg::Node> > *removed);
+    void removeChildrenFromContent(const std::unordered_set<osg::Node*> &nodes);
     void makeSelcetionInRect();
     void makeSelRect(const double xStart, const double yStart, const double xEnd, const double yEnd);
     void duplicateSelection();
@@ -20,6 +20,8 @@
 #include <osgDB/ReadFile>
 #include <cassert>
 #include <sstream>
+#include <unordered_map>
+#include <mutex>
 
 // y is going from down to top
 // x is going from left to right
@@ -52,8 +54,22 @@ namespace osg_graph_viz {
     return type;
   }
 
+  // maps type and domain names to small integers to compare port signatures
+  static int internName(const std::string &name) {
+    static std::unordered_map<std::string, int> ids;
+    // the nodes can be built by the load threads of the view
+    static std::mutex mutex;
+    std::lock_guard<std::mutex> lock(mutex);
+    std::unordered_map<std::string, int>::iterator it = ids.find(name);
+    if(it != ids.end()) return it->second;
+    int id = ids.size();
+    ids[name] = id;
+    return id;
+  }
+
   XRockNode::XRockNode(const NodeInfo &info_, View *v) : RoundBodyNode(v) {
     info = info_;
+    parseDescriptor();
     hidden = false;
     maxPorts = info.numInputs;
     mergeImages["SUM"] = "images/SumPort.png";
@@ -73,39 +89,37 @@ namespace osg_graph_viz {
     portStartY = -headerHeight - mergeIconSize*4;
     width = 150.;
 
-    std::string domain = info.map["domain"];
-    domain = mars::utils::tolower(domain);
-    if(domain == "software") {
+    if(desc.domain == NODE_DOMAIN_SOFTWARE) {
       colorMap["taskNode"].push_back(osg::Vec4(0.92, 1.0, 0.92, 1.0));
       colorMap["taskNode"].push_back(osg::Vec4(0.3, 0.5, 0.3, 1.0));
       colorMap["taskNodeSelected"].push_back(osg::Vec4(0.72, 1.0, 0.77, 1.0));
       colorMap["taskNodeSelected"].push_back(osg::Vec4(0.72, 1.0, 0.77, 1.0));
     }
-      else if(domain == "assembly") {
+      else if(desc.domain == NODE_DOMAIN_ASSEMBLY) {
       colorMap["taskNode"].push_back(osg::Vec4(0.986, 0.752, 0.990, 1.0));
       colorMap["taskNode"].push_back(osg::Vec4(0.842, 0.349, 0.850, 1.0));
       colorMap["taskNodeSelected"].push_back(osg::Vec4(0.954, 0.605, 0.960, 1.0));
       colorMap["taskNodeSelected"].push_back(osg::Vec4(0.954, 0.605, 0.960, 1.0));
     }
-    else if(domain == "electronics") {
+    else if(desc.domain == NODE_DOMAIN_ELECTRONICS) {
       colorMap["taskNode"].push_back(osg::Vec4(0.85, .92, 1., 1.0));
       colorMap["taskNode"].push_back(osg::Vec4(0.3, 0.3, 0.5, 1.0));
       colorMap["taskNodeSelected"].push_back(osg::Vec4(0.72, 0.77, 1., 1.0));
       colorMap["taskNodeSelected"].push_back(osg::Vec4(0.72, .77, 1, 1.0));
     }
-    else if(domain == "mechanics") {
+    else if(desc.domain == NODE_DOMAIN_MECHANICS) {
       colorMap["taskNode"].push_back(osg::Vec4(0.95, .9, 0.8, 1.0));
       colorMap["taskNode"].push_back(osg::Vec4(0.4, 0.4, 0.3, 1.0));
       colorMap["taskNodeSelected"].push_back(osg::Vec4(0.95, 0.8, 0.5, 1.0));
       colorMap["taskNodeSelected"].push_back(osg::Vec4(0.95, 0.8, 0.5, 1.0));
     }
-    else if(domain == "behavior") {
+    else if(desc.domain == NODE_DOMAIN_BEHAVIOR) {
       colorMap["taskNode"].push_back(osg::Vec4(0.876, 0.760, 1.00, 1.0));
       colorMap["taskNode"].push_back(osg::Vec4(0.783, 0.380, 1.00, 1.0));
       colorMap["taskNodeSelected"].push_back(osg::Vec4(0.834, 0.544, 0.99, 1.0));
       colorMap["taskNodeSelected"].push_back(osg::Vec4(0.834, 0.544, 0.99, 1.0));
     }
-    else if(domain == "computation") {
+    else if(desc.domain == NODE_DOMAIN_COMPUTATION) {
       colorMap["taskNode"].push_back(osg::Vec4(1.0, .8, 0.8, 1.0));
       colorMap["taskNode"].push_back(osg::Vec4(0.5, 0.3, 0.3, 1.0));
       colorMap["taskNodeSelected"].push_back(osg::Vec4(1.0, 0.6, 0.6, 1.0));
@@ -140,7 +154,7 @@ namespace osg_graph_viz {
 
     namePosX = 8;
     osg_text::TextAlign align = osg_text::ALIGN_LEFT;
-    nodeName = new osg_text::Text((std::string)info.map["name"], headerFontSize, c,
+    nodeName = new osg_text::Text(desc.name, headerFontSize, c,
                                   namePosX, namePosY, align, 0, 0, 0, 0,
                                   osg_text::Color(), osg_text::Color(),
                                   0, view->getResourcesPath()+"/fonts/stilu/Stilu-SemiBold.ttf");
@@ -148,12 +162,18 @@ namespace osg_graph_viz {
     nodeName->setBackgroundColor(osg_text::Color(0.0, 0.0, 0.0, 0.0));
     pos->addChild((osg::Node*)nodeName->getOSGNode());
     //c.r = c.g = c.b =0.3;
-    nodeType = new osg_text::Text((std::string)info.map["type"], headerFontSize, c,
+    nodeType = new osg_text::Text(desc.type, headerFontSize, c,
                                   namePosX, namePosY-headerFontSize*1.66, align, 0, 0, 0, 0,
                                   osg_text::Color(), osg_text::Color(),
                                   0, view->getResourcesPath()+"/fonts/stilu/Stilu-Light.ttf");
     nodeType->setBackgroundColor(osg_text::Color(0.0, 0.0, 0.0, 0.0));
     pos->addChild((osg::Node*)nodeType->getOSGNode());
+    if(view->getBatchedText()) {
+      textBatch = new TextBatch(view);
+      pos->addChild(textBatch.get());
+      textBatch->add(nodeName.get());
+      textBatch->add(nodeType.get());
+    }
 
     initRoundBody();
     frameUniform->set(osg::Vec3f(2, 15, 0));
@@ -164,11 +184,33 @@ namespace osg_graph_viz {
     portOffsets.push_back(-3.0);
     portOffsets.push_back(0.0);
     filterUpdate();
+    updatePortSignatures();
+  }
+
+  void XRockNode::updatePortSignatures() {
+    int domainId = -1;
+    if(desc.domain != NODE_DOMAIN_NONE) {
+      domainId = internName(desc.domainName);
+    }
+    inTypeIds.resize(desc.inputs.size());
+    inDomainIds.resize(desc.inputs.size());
+    outTypeIds.resize(desc.outputs.size());
+    outDomainIds.resize(desc.outputs.size());
+    // the port domains are only set for assembly nodes
+    for(size_t i=0; i<desc.inputs.size(); ++i) {
+      const PortDescriptor &port = desc.inputs[i];
+      inTypeIds[i] = internName(rockStripType(port.type));
+      inDomainIds[i] = port.domain.empty() ? domainId : internName(port.domain);
+    }
+    for(size_t i=0; i<desc.outputs.size(); ++i) {
+      const PortDescriptor &port = desc.outputs[i];
+      outTypeIds[i] = internName(rockStripType(port.type));
+      outDomainIds[i] = port.domain.empty() ? domainId : internName(port.domain);
+    }
   }
 
   bool XRockNode::getMergeInfo(size_t i, double *bias, double *def, std::string *merge) {
-    std::string domainData = (std::string)(info.map["domain"])+ "Data";
-    std::string name = (std::string)info.map["inputs"][i]["name"];
+    const std::string &name = desc.inputs[i].name;
     ConfigMap *map = &info.map;
     if((*map).hasKey("configuration"))
     {
@@ -210,15 +252,14 @@ namespace osg_graph_viz {
     // handle the inputs
     for(int i=0; i<info.numInputs; ++i) {
       double portPosY = portStartY - portSpaceY*(portCnt);
-      std::string name = (std::string)info.map["inputs"][i]["name"];
-      std::string type = (std::string)info.map["inputs"][i]["type"];
+      const PortDescriptor &port = desc.inputs[i];
+      std::string name = port.name;
+      std::string type = port.type;
       std::string domain;
       std::string merge;
       double biasValue, defValue;
       bool hasMerge = getMergeInfo(i, &biasValue, &defValue, &merge);
-      if(mars::utils::tolower(info.map["domain"]) == "assembly" && info.map["inputs"][i].hasKey("domain")) {
-        domain = mars::utils::tolower(info.map["inputs"][i]["domain"]);
-      }
+      domain = port.domain;
       Port *p;
       if(update) {
         p = inPorts[i];
@@ -228,7 +269,7 @@ namespace osg_graph_viz {
         }
         std::list<osg::ref_ptr<Edge> >::iterator it = p->edges.begin();
         for(; it!=p->edges.end(); ++it) {
-          (*it)->updateToNode((std::string)info.map["name"], name);
+          (*it)->updateToNode(desc.name, name);
         }
       }
       else {
@@ -276,6 +317,7 @@ namespace osg_graph_viz {
                                                0, view->getResourcesPath()+"/fonts/stilu/Stilu-SemiBold.ttf");
         t->setBackgroundColor(osg_text::Color(0.0, 0.0, 0.0, 0.0));
         p->labels.push_back(t);
+        if(textBatch.valid()) textBatch->add(t);
         t = new osg_text::Text(type, portFontSize,c
                                /*osg_text::Color(0.3, 0.3, 0.3, 1)*/, 0.0, portPosY,
                                osg_text::ALIGN_LEFT, 0, 0, 0, 0,
@@ -283,12 +325,13 @@ namespace osg_graph_viz {
                                0, view->getResourcesPath()+"/fonts/stilu/Stilu-Light.ttf");
         t->setBackgroundColor(osg_text::Color(0.0, 0.0, 0.0, 0.0));
         p->labels.push_back(t);
+        if(textBatch.valid()) textBatch->add(t);
       }
       if(update) {
           // Handle port alias
-          if (info.map["inputs"][i].hasKey("alias") && !info.map["inputs"][i]["alias"].getString().empty())
+          if (!port.alias.empty())
           {
-              p->labels[0]->setText(info.map["inputs"][i]["alias"].getString());
+              p->labels[0]->setText(port.alias);
           }
         double x1, x2, y1, y2;
         double w2 = 0;
@@ -301,12 +344,8 @@ namespace osg_graph_viz {
         }
         int interface=0;
         std::string direction;
-        if(info.map["inputs"][i].hasKey("interface")) {
-          interface = info.map["inputs"][i]["interface"];
-        }
-        if(info.map["inputs"][i].hasKey("direction")) {
-          direction << info.map["inputs"][i]["direction"];
-        }
+        interface = port.interface;
+        direction = port.direction;
         if(p->hidden) {
           continue;
         }
@@ -363,16 +402,13 @@ namespace osg_graph_viz {
     portCnt = 0;
     for(int i=0; i<info.numOutputs; ++i) {
       double portPosY = portStartY - portSpaceY*(portCnt);
-      std::string name = (std::string)info.map["outputs"][i]["name"];
-      std::string type = (std::string)info.map["outputs"][i]["type"];
+      const PortDescriptor &port = desc.outputs[i];
+      std::string name = port.name;
+      std::string type = port.type;
       std::string domain;
       std::string direction;
-      if(mars::utils::tolower(info.map["domain"]) == "assembly" && info.map["outputs"][i].hasKey("domain")) {
-        domain = mars::utils::tolower(info.map["outputs"][i]["domain"]);
-      }
-      if(info.map["outputs"][i].hasKey("direction")) {
-        direction << info.map["outputs"][i]["direction"];
-      }
+      domain = port.domain;
+      direction = port.direction;
       Port *p;
       if(update) {
         p = outPorts[i];
@@ -382,7 +418,7 @@ namespace osg_graph_viz {
         }
         std::list<osg::ref_ptr<Edge> >::iterator it = p->edges.begin();
         for(; it!=p->edges.end(); ++it) {
-          (*it)->updateFromNode((std::string)info.map["name"], name);
+          (*it)->updateFromNode(desc.name, name);
         }
       }
       else {
@@ -410,6 +446,7 @@ namespace osg_graph_viz {
                                                0, view->getResourcesPath()+"/fonts/stilu/Stilu-SemiBold.ttf");
         t->setBackgroundColor(osg_text::Color(0.0, 0.0, 0.0, 0.0));
         p->labels.push_back(t);
+        if(textBatch.valid()) textBatch->add(t);
         t = new osg_text::Text(type, portFontSize, c
                                /*osg_text::Color(0.3, 0.3, 0.3, 1)*/,
                                width - (mergeIconSize*2.0 + 2.0),
@@ -419,12 +456,13 @@ namespace osg_graph_viz {
                                view->getResourcesPath()+"/fonts/stilu/Stilu-Light.ttf");
         t->setBackgroundColor(osg_text::Color(0.0, 0.0, 0.0, 0.0));
         p->labels.push_back(t);
+        if(textBatch.valid()) textBatch->add(t);
       }
       if(update) {
           // Handle port alias
-          if (info.map["outputs"][i].hasKey("alias") && !info.map["outputs"][i]["alias"].getString().empty())
+          if (!port.alias.empty())
           {
-              p->labels[0]->setText(info.map["outputs"][i]["alias"].getString());
+              p->labels[0]->setText(port.alias);
           }
         double x1, x2, y1, y2;
         double w2 = 0;
@@ -439,9 +477,7 @@ namespace osg_graph_viz {
         if(p->hidden) {
           continue;
         }
-        if(info.map["outputs"][i].hasKey("interface")) {
-          interface = info.map["outputs"][i]["interface"];
-        }
+        interface = port.interface;
         osg::Vec4 c(1.0, 1.0, 1.0, 1);
         if(!domain.empty()) {
           if(domain == "MECHANICS") {
@@ -496,7 +532,9 @@ namespace osg_graph_viz {
     if(portCnt > maxPorts) {
       maxPorts = portCnt;
     }
+    if(!textVisible) derenderText(false);
     resizeHeight();
+    syncText();
   }
 
   void XRockNode::setLineWidth(double w) {
@@ -519,11 +557,15 @@ namespace osg_graph_viz {
 
   void XRockNode::updateMap(const ConfigMap &map_) {
     ConfigMap map = map_;
+    std::string oldName = getName();
     updateParentFromMap(map);
     info.map = map;
+    parseDescriptor();
+    view->updateNodeName(oldName, this);
+    updatePortSignatures();
     setPosition(info.map["pos"]["x"], info.map["pos"]["y"]);
     // Check for alias (and show this instead of the name if not empty)
-    std::string name = info.map["name"].getString();
+    std::string name = desc.name;
     if (info.map.hasKey("alias") && !info.map["alias"].getString().empty())
     {
         name = info.map["alias"].getString();
@@ -553,8 +595,7 @@ namespace osg_graph_viz {
         if(inPorts[i]->edges.size() == 0) {
           sprintf(def, "[d%g] ", defValue);
         }
-        std::string name = (std::string)info.map["inputs"][i]["name"];
-        inPorts[i]->labels[0]->setText((std::string)bias+def+name);
+        inPorts[i]->labels[0]->setText((std::string)bias+def+desc.inputs[i].name);
       }
     }
     //nodeName->setText("[ " + (std::string)info.map["type"] + " ]  " + (std::string)info.map["name"]);
@@ -585,18 +626,23 @@ namespace osg_graph_viz {
       if(print) {
         sprintf(bias, "[b%g] ", biasValue);
       }
-      std::string name = (std::string)info.map["inputs"][index]["name"];
-      inPorts[index]->labels[0]->setText(bias+name);
+      inPorts[index]->labels[0]->setText(bias+desc.inputs[index].name);
     }
     edge->setEndNode(this);
-    handlePorts(true);
+    if(layoutDeferred) layoutDirty = true;
+    else if(!view->deferLayout(this)) relayout();
   }
 
   void XRockNode::addOutputEdge(int index, Edge* edge) {
     //edge->setStartOffset(portOffsets[outPorts[index]->edges.size()%3]);
     outPorts[index]->edges.push_back(edge);
     edge->setStartNode(this);
-    updateEdges();
+    if(layoutDeferred) layoutDirty = true;
+    else updateEdges();
+  }
+
+  void XRockNode::relayout() {
+    handlePorts(true);
   }
 
   void XRockNode::setSelected(bool b) {
@@ -634,7 +680,7 @@ namespace osg_graph_viz {
         if(-y1 > h) h = -y1;
       }
     }
-    if((std::string)info.map["type"] == "DES") {
+    if(desc.kind == NODE_KIND_DES) {
       h2 = headerHeight + portSpaceY*(maxPorts);
     }
     else {
@@ -643,8 +689,9 @@ namespace osg_graph_viz {
     if(h2 > h) h = h2;
     height = h;
     RoundBodyNode::resizeHeight(h);
-    bGeom->dirtyDisplayList();
+    vertices->dirty();
     bGeom->dirtyBound();
+    updateBounds();
   }
 
   /*void resizeHeight(double h); {
@@ -668,75 +715,110 @@ namespace osg_graph_viz {
     std::vector<std::pair<int, std::string> > r;
     std::pair<int, std::string> p;
     p.first = index;
-    p.second = (std::string)info.map[tag][index]["name"];
+    p.second = tag == "inputs" ? desc.inputs[index].name : desc.outputs[index].name;
     r.push_back(p);
     return r;
   }
 
   void XRockNode::derenderText(const bool readable){
     Node::derenderText(readable);
-    pos->removeChild((osg::Node*)nodeType->getOSGNode());
-    if(readable){
-      pos->addChild((osg::Node*)nodeType->getOSGNode());
+    if(nodeType.valid() && !textBatch.valid()) {
+      ((osg::Node*)nodeType->getOSGNode())->setNodeMask(readable ? ~0u : 0u);
     }
   }
 
   configmaps::ConfigMap XRockNode::getOutPortEdgeInfo(int index) {
     ConfigMap map;
-    assert(index >= 0 && index < info.map["outputs"].size());
-    map["dataType"] = info.map["outputs"][index]["type"];
+    assert(index >= 0 && index < (int)desc.outputs.size());
+    const PortDescriptor &port = desc.outputs[index];
+    map["dataType"] = port.type;
     // todo: hanel source node on name change
-    map["sourceNode"] = info.map["name"];
-    if(info.map["outputs"][index].hasKey("domain")) {
-      map["domain"] = info.map["outputs"][index]["domain"];
+    map["sourceNode"] = desc.name;
+    if(!port.domain.empty()) {
+      map["domain"] = port.domain;
     }
     return map;
   }
 
-  // todo: move this to bagel model
-  bool XRockNode::isCompatible(ConfigMap &map, size_t index) {
-    assert(index >= 0 && index < info.map["inputs"].size());
+  bool XRockNode::getOutPortSignature(int index, int *typeId, int *domainId) {
+    if(index < 0 || index >= (int)outTypeIds.size()) return false;
+    *typeId = outTypeIds[index];
+    *domainId = outDomainIds[index];
+    return true;
+  }
+
+  // only used for edge infos of nodes that are no XRockNodes
+  bool XRockNode::getEdgeInfoSignature(ConfigMap &map, int *typeId,
+                                       int *domainId) {
     std::string sourceNode = map["sourceNode"];
-    //if((std::string)info.map["name"] == sourceNode) return false;
-    // todo: check domain
     osg::ref_ptr<Node> source = view->getNodeByName(sourceNode);
-    ConfigMap sourceMap = source->getMap();
-    if(sourceMap.hasKey("domain")) {
-      std::string sourceDomain = mars::utils::tolower(sourceMap["domain"]);
-      if(sourceDomain == "assembly" && map.hasKey("domain")) {
-        sourceDomain = mars::utils::tolower(map["domain"]);
-      }
-      if(!info.map.hasKey("domain")) return false;
-      std::string targetDomain = mars::utils::tolower(info.map["domain"]);
-      if(targetDomain == "assembly") {
-        if(info.map["inputs"][index].hasKey("domain")) {
-          targetDomain = mars::utils::tolower(info.map["inputs"][index]["domain"]);
-        }
-      }
-      //fprintf(stderr, "domains: %s %s\n", sourceDomain.c_str(), targetDomain.c_str());
-      if(sourceDomain != targetDomain) return false;
-      return (rockStripType(map["dataType"]) == rockStripType(info.map["inputs"][index]["type"]));
+    if(!source.valid()) return false;
+    const NodeDescriptor &sourceDesc = source->getDescriptor();
+    if(sourceDesc.domain == NODE_DOMAIN_NONE) return false;
+    std::string sourceDomain = sourceDesc.domainName;
+    if(sourceDesc.domain == NODE_DOMAIN_ASSEMBLY && map.hasKey("domain")) {
+      sourceDomain = mars::utils::tolower(map["domain"]);
+    }
+    *domainId = internName(sourceDomain);
+    *typeId = internName(rockStripType(map["dataType"]));
+    return true;
+  }
+
+  // todo: move this to bagel model
+  bool XRockNode::isCompatible(int typeId, int domainId, size_t index) {
+    assert(index < inTypeIds.size());
+    if(domainId < 0 || inDomainIds[index] < 0) return false;
+    return domainId == inDomainIds[index] && typeId == inTypeIds[index];
+  }
+
+  bool XRockNode::isCompatible(ConfigMap &map, size_t index) {
+    int typeId, domainId;
+    if(!getEdgeInfoSignature(map, &typeId, &domainId)) return false;
+    return isCompatible(typeId, domainId, index);
+  }
+
+  bool XRockNode::isCompatible(Node *source, int sourceIdx, size_t index) {
+    XRockNode *xSource = dynamic_cast<XRockNode*>(source);
+    if(!xSource) return Node::isCompatible(source, sourceIdx, index);
+    int typeId, domainId;
+    if(!xSource->getOutPortSignature(sourceIdx, &typeId, &domainId)) {
+      return false;
     }
-    return false;
+    return isCompatible(typeId, domainId, index);
   }
 
   void XRockNode::markInputsByEdgeInfo(ConfigMap &map) {
+    int typeId, domainId;
+    if(!getEdgeInfoSignature(map, &typeId, &domainId)) return;
+    markInputs(typeId, domainId);
+  }
+
+  void XRockNode::markCompatibleInputs(Node *source, int sourceIdx) {
+    XRockNode *xSource = dynamic_cast<XRockNode*>(source);
+    if(!xSource) {
+      Node::markCompatibleInputs(source, sourceIdx);
+      return;
+    }
+    int typeId, domainId;
+    if(xSource->getOutPortSignature(sourceIdx, &typeId, &domainId)) {
+      markInputs(typeId, domainId);
+    }
+  }
+
+  void XRockNode::markInputs(int typeId, int domainId) {
     std::vector<Port*>::iterator it = inPorts.begin();
     size_t i=0;
-    for(; it!=inPorts.end(); ++it, ++i) {
-      if(isCompatible(map, i)) {
+    for(; it!=inPorts.end() && i<inTypeIds.size(); ++it, ++i) {
+      if(isCompatible(typeId, domainId, i)) {
         osg::Vec4Array *colors;
         osg::Geometry *geom;
         geom = (*it)->group->getChild(0)->asGeode()->getDrawable(0)->asGeometry();
         colors = dynamic_cast< osg::Vec4Array *>(geom->getColorArray());
         colors->operator[](1) = osg::Vec4(0.75, 1, 0.75, 1);
         //fprintf(stderr, "change color in %s\n", info.map["name"].c_str());
-        geom->dirtyDisplayList();
-        geom->dirtyBound();
+        colors->dirty();
       }
     }
-    bGeom->dirtyDisplayList();
-    bGeom->dirtyBound();
   }
 
   void XRockNode::unmarkInputs() {
@@ -746,14 +828,8 @@ namespace osg_graph_viz {
       osg::Geometry *geom;
       geom = (*it)->group->getChild(0)->asGeode()->getDrawable(0)->asGeometry();
       colors = dynamic_cast< osg::Vec4Array *>(geom->getColorArray());
-      int interface = 0;
-      if(info.map["inputs"][i].hasKey("interface")) {
-        interface = info.map["inputs"][i]["interface"];
-      }
-      std::string domain;
-      if(mars::utils::tolower(info.map["domain"]) == "assembly" && info.map["inputs"][i].hasKey("domain")) {
-        domain = mars::utils::tolower(info.map["inputs"][i]["domain"]);
-      }
+      int interface = desc.inputs[i].interface;
+      const std::string &domain = desc.inputs[i].domain;
       osg::Vec4 c(1.0, 1.0, 1.0, 1);
       if(!interface && !domain.empty()) {
         if(domain == "MECHANICS") {
@@ -779,25 +855,17 @@ namespace osg_graph_viz {
         c = osg::Vec4(1.0, 1.0, 0.7, 1);
       }
       colors->operator[](1) = c;
-      geom->dirtyDisplayList();
-      geom->dirtyBound();
+      colors->dirty();
     }
-    bGeom->dirtyDisplayList();
-    bGeom->dirtyBound();
   }
 
   void XRockNode::filterUpdate() {
     std::map<std::string, int> &filterMap = view->getFilterMap();
     std::map<std::string, int>::iterator it;
-    std::string domain = mars::utils::tolower(info.map["domain"]);
-    if(domain == "assembly") {
+    if(desc.domain == NODE_DOMAIN_ASSEMBLY) {
       for(size_t i=0; i<inPorts.size(); ++i) {
         Port *p = inPorts[i];
-        std::string iDomain;
-        if(info.map["inputs"][i].hasKey("domain")) {
-          iDomain = mars::utils::tolower(info.map["inputs"][i]["domain"]);
-        }
-        it=filterMap.find(iDomain);
+        it=filterMap.find(desc.inputs[i].domain);
         if(it!=filterMap.end()) {
           pos->removeChild(p->geode);
           pos->removeChild(p->group);
@@ -817,11 +885,7 @@ namespace osg_graph_viz {
       }
       for(size_t i=0; i<outPorts.size(); ++i) {
         Port *p = outPorts[i];
-        std::string iDomain;
-        if(info.map["outputs"][i].hasKey("domain")) {
-          iDomain = mars::utils::tolower(info.map["outputs"][i]["domain"]);
-        }
-        it=filterMap.find(iDomain);
+        it=filterMap.find(desc.outputs[i].domain);
         if(it!=filterMap.end()) {
           pos->removeChild(p->geode);
           pos->removeChild(p->group);
@@ -841,7 +905,7 @@ namespace osg_graph_viz {
       }
     }
     else {
-      it=filterMap.find(domain);
+      it=filterMap.find(desc.domainName);
       if(it!=filterMap.end()) {
         if(it->second && hidden) {
           view->addNodeToView(this);
@@ -858,6 +922,9 @@ namespace osg_graph_viz {
     }
     handlePorts(true);
     updateEdges();
+    // also updates the body instances of the children
+    updateBounds();
+    view->updateFlatNode(this);
   }
 
   void XRockNode::handlePortEdgeVisibility(Port *p, bool hide) {
@@ -888,8 +955,9 @@ namespace osg_graph_viz {
     double left, right, top, bottom;
     nodeName->getRectangle(&left, &right, &top, &bottom);
     nodeName->setPosition(8, top);
-    bGeom->dirtyDisplayList();
+    vertices->dirty();
     bGeom->dirtyBound();
+    syncText();
   }
 
   void XRockNode::applyFontScale(double s) {
@@ -904,6 +972,10 @@ namespace osg_graph_viz {
     else if(x<256) x=256;
     else x=512;
     nodeType->setFontResolution(x, x);
+    if(textBatch.valid()) {
+      textBatch->setFontResolution(x);
+      syncText();
+    }
   }
 
   void XRockNode::exportSvg(FILE *f, double ol, double ot) {
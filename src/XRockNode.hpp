@@ -36,6 +36,9 @@ namespace osg_graph_viz {
     void markInputsByEdgeInfo(configmaps::ConfigMap &map);
     void unmarkInputs();
     bool isCompatible(configmaps::ConfigMap &map, size_t index);
+    bool isCompatible(Node *source, int sourceIdx, size_t index);
+    void markCompatibleInputs(Node *source, int sourceIdx);
+    bool getOutPortSignature(int index, int *typeId, int *domainId);
     void filterUpdate();
     void resizeWidth(double h);
     void applyFontScale(double s);
@@ -77,15 +80,23 @@ namespace osg_graph_viz {
     std::map<std::string, std::unique_ptr<Tooltip>> tooltips;
     std::vector<Frame> frames;
     osg::ref_ptr<osg_text::Text> nodeType;
+    // interned type and domain of each port, -1 if the node has no domain
+    std::vector<int> inTypeIds, inDomainIds, outTypeIds, outDomainIds;
 
     void handlePorts(bool update=false);
     void resizeHeight();
+    void relayout();
     //void resizeWidth(double w);
     //void resizeHeight(double h);
     //void derenderTextInPort(const bool readable);
     void handleFilterEdges(bool hide);
     void handlePortEdgeVisibility(Port *p, bool hide);
     bool getMergeInfo(size_t i, double *bias, double *def, std::string *merge);
+    void updatePortSignatures();
+    bool getEdgeInfoSignature(configmaps::ConfigMap &map, int *typeId,
+                              int *domainId);
+    bool isCompatible(int typeId, int domainId, size_t index);
+    void markInputs(int typeId, int domainId);
 
   };
 
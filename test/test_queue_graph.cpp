@@ -0,0 +1,53 @@
+/**
+ * \file test_queue_graph.cpp
+ * \brief Loads a queued graph with an edge to an unknown node.
+ **/
+
+#include "View.hpp"
+
+#include <cstdio>
+
+using namespace osg_graph_viz;
+using namespace configmaps;
+
+static const char *graphYaml =
+  "nodes:\n"
+  "  - {name: a, type: test, pos: {x: 0.0, y: 0.0},\n"
+  "     inputs: [{name: in}], outputs: [{name: out}]}\n"
+  "  - {name: b, type: test, pos: {x: 200.0, y: 0.0},\n"
+  "     inputs: [{name: in}], outputs: [{name: out}]}\n"
+  "edges:\n"
+  "  - {fromNode: a, fromNodeOutput: out, toNode: unknown, toNodeInput: in}\n"
+  "  - {fromNode: a, fromNodeOutput: out, toNode: b, toNodeInput: in}\n";
+
+int main(int argc, char **argv) {
+  osg::ref_ptr<View> view = new View();
+  if(argc > 1) view->setResourcesPath(argv[1]);
+  view->init(12.0, 10.0, 1.0);
+
+  // the first edge has one queued and one unknown end and is skipped, it
+  // must not leave a waiting entry behind for the second edge
+  view->queueGraph(ConfigMap::fromYamlString(graphYaml));
+  for(int i=0; i<1000 && view->isLoading(); ++i) {
+    view->update();
+  }
+
+  int rc = 0;
+  if(view->isLoading()) {
+    fprintf(stderr, "the queue is not finished\n");
+    rc = 1;
+  }
+  osg::ref_ptr<Node> a = view->getNodeByName("a");
+  osg::ref_ptr<Node> b = view->getNodeByName("b");
+  if(!a.valid() || !b.valid()) {
+    fprintf(stderr, "the nodes are not created\n");
+    return 1;
+  }
+  std::vector<osg::ref_ptr<Edge> > edges = a->getOutputEdges();
+  if(edges.size() != 1 || edges[0]->getEndNode() != b.get()) {
+    fprintf(stderr, "expected one edge from a to b, got %d\n",
+            (int)edges.size());
+    rc = 1;
+  }
+  return rc;
+}